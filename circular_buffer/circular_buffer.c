@@ -12,6 +12,19 @@
 
 #include <string.h>
 
+static inline uint8_t *_CIRCULAR_BUFFER_slot(CIRCULAR_BUFFER_HandleTypeDef *handle, uint32_t index) {
+    return (uint8_t *)handle->buffer + index * handle->size;
+}
+
+static inline void _CIRCULAR_BUFFER_account(CIRCULAR_BUFFER_HandleTypeDef *handle, uint32_t n) {
+    uint32_t count = CIRCULAR_BUFFER_count(handle);
+
+    handle->stats.enqueued += n;
+    if (count > handle->stats.high_water) {
+        handle->stats.high_water = count;
+    }
+}
+
 STMLIBS_StatusTypeDef CIRCULAR_BUFFER_init(CIRCULAR_BUFFER_HandleTypeDef *handle,
                                            void *buffer,
                                            uint32_t length,
@@ -29,6 +42,41 @@ STMLIBS_StatusTypeDef CIRCULAR_BUFFER_init(CIRCULAR_BUFFER_HandleTypeDef *handle
     handle->size   = el_size;
     handle->head   = 0;
     handle->tail   = 0;
+    handle->policy = CIRCULAR_BUFFER_REJECT_NEW;
+
+    return CIRCULAR_BUFFER_reset_stats(handle);
+}
+
+STMLIBS_StatusTypeDef CIRCULAR_BUFFER_set_policy(CIRCULAR_BUFFER_HandleTypeDef *handle,
+                                                 CIRCULAR_BUFFER_PolicyTypeDef policy) {
+    if (handle == NULL) {
+        return STMLIBS_ERROR;
+    }
+
+    handle->policy = policy;
+
+    return STMLIBS_OK;
+}
+
+STMLIBS_StatusTypeDef CIRCULAR_BUFFER_get_stats(CIRCULAR_BUFFER_HandleTypeDef *handle,
+                                                CIRCULAR_BUFFER_StatsTypeDef *stats) {
+    if (handle == NULL || stats == NULL) {
+        return STMLIBS_ERROR;
+    }
+
+    *stats = handle->stats;
+
+    return STMLIBS_OK;
+}
+
+STMLIBS_StatusTypeDef CIRCULAR_BUFFER_reset_stats(CIRCULAR_BUFFER_HandleTypeDef *handle) {
+    if (handle == NULL) {
+        return STMLIBS_ERROR;
+    }
+
+    handle->stats.high_water = 0;
+    handle->stats.dropped    = 0;
+    handle->stats.enqueued   = 0;
 
     return STMLIBS_OK;
 }
@@ -49,6 +97,26 @@ uint8_t CIRCULAR_BUFFER_is_empty(CIRCULAR_BUFFER_HandleTypeDef *handle) {
     return handle->head == handle->tail;
 }
 
+uint32_t CIRCULAR_BUFFER_count(CIRCULAR_BUFFER_HandleTypeDef *handle) {
+    if (handle == NULL) {
+        return 0;
+    }
+
+    uint32_t head = handle->head;
+    uint32_t tail = handle->tail;
+
+    return head >= tail ? head - tail : handle->length - tail + head;
+}
+
+uint32_t CIRCULAR_BUFFER_free_space(CIRCULAR_BUFFER_HandleTypeDef *handle) {
+    if (handle == NULL) {
+        return 0;
+    }
+
+    // One slot is always left empty to tell a full buffer from an empty one
+    return handle->length - 1 - CIRCULAR_BUFFER_count(handle);
+}
+
 STMLIBS_StatusTypeDef CIRCULAR_BUFFER_enqueue(CIRCULAR_BUFFER_HandleTypeDef *handle, void *obj) {
     if (handle == NULL) {
         return STMLIBS_ERROR;
@@ -59,11 +127,18 @@ STMLIBS_StatusTypeDef CIRCULAR_BUFFER_enqueue(CIRCULAR_BUFFER_HandleTypeDef *han
     }
 
     if (CIRCULAR_BUFFER_is_full(handle)) {
-        return STMLIBS_ERROR;
+        ++handle->stats.dropped;
+
+        if (handle->policy != CIRCULAR_BUFFER_OVERWRITE_OLDEST) {
+            return STMLIBS_ERROR;
+        }
+
+        handle->tail = (handle->tail + 1) % handle->length;
     }
 
-    memcpy(handle->buffer + handle->head, obj, handle->size);
+    memcpy(_CIRCULAR_BUFFER_slot(handle, handle->head), obj, handle->size);
     handle->head = (handle->head + 1) % handle->length;
+    _CIRCULAR_BUFFER_account(handle, 1);
 
     return STMLIBS_OK;
 }
@@ -81,8 +156,125 @@ STMLIBS_StatusTypeDef CIRCULAR_BUFFER_dequeue(CIRCULAR_BUFFER_HandleTypeDef *han
         return STMLIBS_ERROR;
     }
 
-    memcpy(obj, handle->buffer + handle->tail, handle->size);
+    memcpy(obj, _CIRCULAR_BUFFER_slot(handle, handle->tail), handle->size);
     handle->tail = (handle->tail + 1) % handle->length;
 
     return STMLIBS_OK;
-}
\ No newline at end of file
+}
+
+uint32_t CIRCULAR_BUFFER_enqueue_n(CIRCULAR_BUFFER_HandleTypeDef *handle, const void *objs, uint32_t n) {
+    if (handle == NULL || objs == NULL) {
+        return 0;
+    }
+
+    uint32_t free_space = CIRCULAR_BUFFER_free_space(handle);
+    if (n > free_space) {
+        if (handle->policy == CIRCULAR_BUFFER_OVERWRITE_OLDEST) {
+            // Only the newest length - 1 elements of objs can survive
+            uint32_t capacity = handle->length - 1;
+            if (n > capacity) {
+                handle->stats.dropped += n - capacity;
+                objs = (const uint8_t *)objs + (n - capacity) * handle->size;
+                n    = capacity;
+            }
+
+            handle->stats.dropped += n - free_space;
+            handle->tail = (handle->tail + n - free_space) % handle->length;
+        } else {
+            handle->stats.dropped += n - free_space;
+            n = free_space;
+        }
+    }
+
+    // Copy up to the end of the storage, then wrap around to its start
+    uint32_t first = handle->length - handle->head;
+    if (first > n) {
+        first = n;
+    }
+
+    memcpy(_CIRCULAR_BUFFER_slot(handle, handle->head), objs, first * handle->size);
+    memcpy(_CIRCULAR_BUFFER_slot(handle, 0), (const uint8_t *)objs + first * handle->size, (n - first) * handle->size);
+    handle->head = (handle->head + n) % handle->length;
+    _CIRCULAR_BUFFER_account(handle, n);
+
+    return n;
+}
+
+uint32_t CIRCULAR_BUFFER_dequeue_n(CIRCULAR_BUFFER_HandleTypeDef *handle, void *objs, uint32_t n) {
+    if (handle == NULL || objs == NULL) {
+        return 0;
+    }
+
+    uint32_t count = CIRCULAR_BUFFER_count(handle);
+    if (n > count) {
+        n = count;
+    }
+
+    uint32_t first = handle->length - handle->tail;
+    if (first > n) {
+        first = n;
+    }
+
+    memcpy(objs, _CIRCULAR_BUFFER_slot(handle, handle->tail), first * handle->size);
+    memcpy((uint8_t *)objs + first * handle->size, _CIRCULAR_BUFFER_slot(handle, 0), (n - first) * handle->size);
+    handle->tail = (handle->tail + n) % handle->length;
+
+    return n;
+}
+
+uint32_t CIRCULAR_BUFFER_reserve(CIRCULAR_BUFFER_HandleTypeDef *handle, void **span) {
+    if (handle == NULL || span == NULL) {
+        return 0;
+    }
+
+    uint32_t free_space = CIRCULAR_BUFFER_free_space(handle);
+    uint32_t contiguous = handle->length - handle->head;
+
+    *span = _CIRCULAR_BUFFER_slot(handle, handle->head);
+
+    return contiguous < free_space ? contiguous : free_space;
+}
+
+STMLIBS_StatusTypeDef CIRCULAR_BUFFER_commit(CIRCULAR_BUFFER_HandleTypeDef *handle, uint32_t n) {
+    if (handle == NULL) {
+        return STMLIBS_ERROR;
+    }
+
+    void *span;
+    if (n > CIRCULAR_BUFFER_reserve(handle, &span)) {
+        return STMLIBS_ERROR;
+    }
+
+    handle->head = (handle->head + n) % handle->length;
+    _CIRCULAR_BUFFER_account(handle, n);
+
+    return STMLIBS_OK;
+}
+
+uint32_t CIRCULAR_BUFFER_peek(CIRCULAR_BUFFER_HandleTypeDef *handle, void **span) {
+    if (handle == NULL || span == NULL) {
+        return 0;
+    }
+
+    uint32_t count      = CIRCULAR_BUFFER_count(handle);
+    uint32_t contiguous = handle->length - handle->tail;
+
+    *span = _CIRCULAR_BUFFER_slot(handle, handle->tail);
+
+    return contiguous < count ? contiguous : count;
+}
+
+STMLIBS_StatusTypeDef CIRCULAR_BUFFER_release(CIRCULAR_BUFFER_HandleTypeDef *handle, uint32_t n) {
+    if (handle == NULL) {
+        return STMLIBS_ERROR;
+    }
+
+    void *span;
+    if (n > CIRCULAR_BUFFER_peek(handle, &span)) {
+        return STMLIBS_ERROR;
+    }
+
+    handle->tail = (handle->tail + n) % handle->length;
+
+    return STMLIBS_OK;
+}
@@ -16,12 +16,29 @@
 
 #include <inttypes.h>
 
+typedef enum {
+    /** @brief Enqueueing on a full buffer fails, the new elements are dropped */
+    CIRCULAR_BUFFER_REJECT_NEW,
+    /** @brief Enqueueing on a full buffer drops the oldest elements */
+    CIRCULAR_BUFFER_OVERWRITE_OLDEST
+} CIRCULAR_BUFFER_PolicyTypeDef;
+
+struct CIRCULAR_BUFFER_StatsStruct {
+    uint32_t high_water;
+    uint32_t dropped;
+    uint32_t enqueued;
+};
+typedef struct CIRCULAR_BUFFER_StatsStruct CIRCULAR_BUFFER_StatsTypeDef;
+
 struct CIRCULAR_BUFFER_HandleStruct {
     void *buffer;
     uint32_t length;
     uint32_t size;
     uint32_t head;
     uint32_t tail;
+
+    CIRCULAR_BUFFER_PolicyTypeDef policy;
+    CIRCULAR_BUFFER_StatsTypeDef stats;
 };
 typedef struct CIRCULAR_BUFFER_HandleStruct CIRCULAR_BUFFER_HandleTypeDef;
 
@@ -30,8 +47,83 @@ STMLIBS_StatusTypeDef CIRCULAR_BUFFER_init(CIRCULAR_BUFFER_HandleTypeDef *handle
                                            uint32_t length,
                                            uint32_t el_size);
 
+/**
+ * @brief     Select what happens when enqueueing on a full buffer, by default
+ *                new elements are rejected. The overwrite policy moves tail
+ *                from the producer side, so producer and consumer must not
+ *                preempt each other.
+ *
+ * @param     handle Reference to the handle
+ * @param     policy Full buffer policy
+ * @return    STMLIBS_OK on success, STMLIBS_ERROR on failure
+ */
+STMLIBS_StatusTypeDef CIRCULAR_BUFFER_set_policy(CIRCULAR_BUFFER_HandleTypeDef *handle,
+                                                 CIRCULAR_BUFFER_PolicyTypeDef policy);
+/**
+ * @brief     Copy the occupancy counters: highest number of stored elements,
+ *                elements lost to a full buffer and elements enqueued
+ *
+ * @param     handle Reference to the handle
+ * @param     stats Destination of the counters
+ * @return    STMLIBS_OK on success, STMLIBS_ERROR on failure
+ */
+STMLIBS_StatusTypeDef CIRCULAR_BUFFER_get_stats(CIRCULAR_BUFFER_HandleTypeDef *handle,
+                                                CIRCULAR_BUFFER_StatsTypeDef *stats);
+
+STMLIBS_StatusTypeDef CIRCULAR_BUFFER_reset_stats(CIRCULAR_BUFFER_HandleTypeDef *handle);
+
+uint8_t CIRCULAR_BUFFER_is_full(CIRCULAR_BUFFER_HandleTypeDef *handle);
+
+uint8_t CIRCULAR_BUFFER_is_empty(CIRCULAR_BUFFER_HandleTypeDef *handle);
+
+uint32_t CIRCULAR_BUFFER_count(CIRCULAR_BUFFER_HandleTypeDef *handle);
+
+uint32_t CIRCULAR_BUFFER_free_space(CIRCULAR_BUFFER_HandleTypeDef *handle);
+
 STMLIBS_StatusTypeDef CIRCULAR_BUFFER_enqueue(CIRCULAR_BUFFER_HandleTypeDef *handle, void *obj);
 
 STMLIBS_StatusTypeDef CIRCULAR_BUFFER_dequeue(CIRCULAR_BUFFER_HandleTypeDef *handle, void *obj);
 
+uint32_t CIRCULAR_BUFFER_enqueue_n(CIRCULAR_BUFFER_HandleTypeDef *handle, const void *objs, uint32_t n);
+
+uint32_t CIRCULAR_BUFFER_dequeue_n(CIRCULAR_BUFFER_HandleTypeDef *handle, void *objs, uint32_t n);
+
+/**
+ * @brief     Get the contiguous writable span starting at head, the elements
+ *                are written in place (e.g. by DMA) and then made visible with
+ *                @CIRCULAR_BUFFER_commit. When the free space wraps around the
+ *                end of the storage, a second reserve after the commit returns
+ *                the remaining part.
+ *
+ * @param     handle Reference to the handle
+ * @param     span Set to the first writable element
+ * @return    number of contiguous writable elements
+ */
+uint32_t CIRCULAR_BUFFER_reserve(CIRCULAR_BUFFER_HandleTypeDef *handle, void **span);
+/**
+ * @brief     Publish n elements written in the span returned by @CIRCULAR_BUFFER_reserve
+ *
+ * @param     handle Reference to the handle
+ * @param     n Number of elements written
+ * @return    STMLIBS_OK on success, STMLIBS_ERROR if n exceeds the reserved span
+ */
+STMLIBS_StatusTypeDef CIRCULAR_BUFFER_commit(CIRCULAR_BUFFER_HandleTypeDef *handle, uint32_t n);
+/**
+ * @brief     Get the contiguous readable span starting at tail, the elements
+ *                stay in the buffer until @CIRCULAR_BUFFER_release is called
+ *
+ * @param     handle Reference to the handle
+ * @param     span Set to the oldest element
+ * @return    number of contiguous readable elements
+ */
+uint32_t CIRCULAR_BUFFER_peek(CIRCULAR_BUFFER_HandleTypeDef *handle, void **span);
+/**
+ * @brief     Drop n elements from the span returned by @CIRCULAR_BUFFER_peek
+ *
+ * @param     handle Reference to the handle
+ * @param     n Number of elements processed
+ * @return    STMLIBS_OK on success, STMLIBS_ERROR if n exceeds the peeked span
+ */
+STMLIBS_StatusTypeDef CIRCULAR_BUFFER_release(CIRCULAR_BUFFER_HandleTypeDef *handle, uint32_t n);
+
 #endif  //CIRCULAR_BUFFER_H
\ No newline at end of file
@@ -0,0 +1,101 @@
+/**
+ * @file      circular_buffer_gen.h
+ * @prefix    CIRCBUF
+ * @author    Federico Carbone [federico.carbone.sc@gmail.com]
+ *
+ * @brief     Typed, statically sized circular buffer generator header
+ *
+ * @license   Licensed under "THE BEER-WARE LICENSE", Revision 69 (see LICENSE)
+ *
+ @verbatim
+                    ##### How to use this generator #####
+ ===============================================================================
+ (#) Declare the buffer type and its functions once per element type, the
+     capacity must be a power of two:
+
+     CIRCBUF_DECL(struct CAN_Frame, can, 64);
+
+ (#) Instantiate and initialize a buffer:
+
+     static struct CIRCBUF_Handle_can can_rx;
+     CIRCBUF_Init_can(&can_rx);
+
+ (#) Push and pop elements by value:
+
+     CIRCBUF_Push_can(&can_rx, frame);
+     if (CIRCBUF_Pop_can(&can_rx, &frame) == 0) { ... }
+
+                             ##### PERFORMANCE #####
+ ===============================================================================
+ All the functions are static inline: element size and capacity are compile
+ time constants, so a push/pop is an assignment plus an index mask and, with a
+ statically allocated buffer, the handle pointer folds into absolute addresses.
+
+ Like CIRCULAR_BUFFER, calls from different interrupt priorities on the same
+ buffer must be serialized by the caller.
+ @endverbatim
+ */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef _CIRCBUF_GEN_
+#define _CIRCBUF_GEN_
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+
+/* Internal macros -----------------------------------------------------------*/
+
+#define __IS_CIRCBUF_CAPACITY(CAPACITY) ((CAPACITY) > 0 && ((CAPACITY) & ((CAPACITY)-1)) == 0)
+
+/* head and tail are free running counters, all the capacity slots are usable */
+#define CIRCBUF_DECL_HANDLE(elem_t, suffix, capacity)                                           \
+    _Static_assert(__IS_CIRCBUF_CAPACITY(capacity), "CIRCBUF capacity must be a power of two"); \
+    struct CIRCBUF_Handle_##suffix {                                                            \
+        elem_t buffer[capacity];                                                                \
+        uint32_t head;                                                                          \
+        uint32_t tail;                                                                          \
+    }
+
+#define CIRCBUF_DECL_INIT_FN(elem_t, suffix, capacity)                              \
+    static inline void CIRCBUF_Init_##suffix(struct CIRCBUF_Handle_##suffix *hcb) { \
+        hcb->head = 0;                                                              \
+        hcb->tail = 0;                                                              \
+    }
+
+#define CIRCBUF_DECL_COUNT_FN(elem_t, suffix, capacity)                                  \
+    static inline uint32_t CIRCBUF_Count_##suffix(struct CIRCBUF_Handle_##suffix *hcb) { \
+        return hcb->head - hcb->tail;                                                    \
+    }                                                                                    \
+    static inline int CIRCBUF_IsEmpty_##suffix(struct CIRCBUF_Handle_##suffix *hcb) {    \
+        return hcb->head == hcb->tail;                                                   \
+    }                                                                                    \
+    static inline int CIRCBUF_IsFull_##suffix(struct CIRCBUF_Handle_##suffix *hcb) {     \
+        return hcb->head - hcb->tail == (capacity);                                      \
+    }
+
+#define CIRCBUF_DECL_PUSH_FN(elem_t, suffix, capacity)                                           \
+    static inline int CIRCBUF_Push_##suffix(struct CIRCBUF_Handle_##suffix *hcb, elem_t value) { \
+        if (hcb->head - hcb->tail == (capacity))                                                 \
+            return (-1);                                                                         \
+        hcb->buffer[hcb->head & ((capacity)-1)] = value;                                         \
+        ++hcb->head;                                                                             \
+        return 0;                                                                                \
+    }
+
+#define CIRCBUF_DECL_POP_FN(elem_t, suffix, capacity)                                            \
+    static inline int CIRCBUF_Pop_##suffix(struct CIRCBUF_Handle_##suffix *hcb, elem_t *value) { \
+        if (hcb->head == hcb->tail)                                                              \
+            return (-1);                                                                         \
+        *value = hcb->buffer[hcb->tail & ((capacity)-1)];                                        \
+        ++hcb->tail;                                                                             \
+        return 0;                                                                                \
+    }
+
+#define CIRCBUF_DECL(elem_t, suffix, capacity)      \
+    CIRCBUF_DECL_HANDLE(elem_t, suffix, capacity);  \
+    CIRCBUF_DECL_INIT_FN(elem_t, suffix, capacity)  \
+    CIRCBUF_DECL_COUNT_FN(elem_t, suffix, capacity) \
+    CIRCBUF_DECL_PUSH_FN(elem_t, suffix, capacity)  \
+    CIRCBUF_DECL_POP_FN(elem_t, suffix, capacity)
+
+#endif  // _CIRCBUF_GEN_
@@ -0,0 +1,136 @@
+/*
+ * "THE BEER-WARE LICENSE" (Revision 69):
+ * Squadra Corse firmware team wrote this file. As long as you retain this notice
+ * you can do whatever you want with this stuff. If we meet some day, and you
+ * think this stuff is worth it, you can buy us a beer in return.
+ *
+ * Authors
+ * - Federico Carbone [federico.carbone.sc@gmail.com]
+ */
+
+#include "circular_buffer_mpsc.h"
+
+#include <string.h>
+
+STMLIBS_StatusTypeDef CIRCULAR_BUFFER_MPSC_init(CIRCULAR_BUFFER_MPSC_HandleTypeDef *handle,
+                                                void *buffer,
+                                                CIRCULAR_BUFFER_MPSC_SequenceTypeDef *sequences,
+                                                uint32_t length,
+                                                uint32_t el_size) {
+    if (handle == NULL) {
+        return STMLIBS_ERROR;
+    }
+
+    if (buffer == NULL || sequences == NULL) {
+        return STMLIBS_ERROR;
+    }
+
+    // With one slot the published sequence of an element is also the free one of the next lap
+    if (length < 2 || (length & (length - 1)) != 0) {
+        return STMLIBS_ERROR;
+    }
+
+    handle->buffer    = buffer;
+    handle->sequences = sequences;
+    handle->mask      = length - 1;
+    handle->size      = el_size;
+    handle->tail      = 0;
+    atomic_init(&handle->head, 0);
+
+    for (uint32_t i = 0; i < length; ++i) {
+        atomic_init(&handle->sequences[i], i);
+    }
+
+    return STMLIBS_OK;
+}
+
+STMLIBS_StatusTypeDef CIRCULAR_BUFFER_MPSC_enqueue(CIRCULAR_BUFFER_MPSC_HandleTypeDef *handle, const void *obj) {
+    if (handle == NULL || obj == NULL) {
+        return STMLIBS_ERROR;
+    }
+
+    uint32_t pos = atomic_load_explicit(&handle->head, memory_order_relaxed);
+    CIRCULAR_BUFFER_MPSC_SequenceTypeDef *sequence;
+
+    for (;;) {
+        sequence     = &handle->sequences[pos & handle->mask];
+        int32_t diff = (int32_t)(atomic_load_explicit(sequence, memory_order_acquire) - pos);
+
+        if (diff == 0) {
+            // On failure pos is reloaded with the position claimed by the preempting producer
+            if (atomic_compare_exchange_weak_explicit(
+                    &handle->head, &pos, pos + 1, memory_order_relaxed, memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            // The slot still holds the element of the previous lap
+            return STMLIBS_ERROR;
+        } else {
+            pos = atomic_load_explicit(&handle->head, memory_order_relaxed);
+        }
+    }
+
+    memcpy(handle->buffer + (pos & handle->mask) * handle->size, obj, handle->size);
+    atomic_store_explicit(sequence, pos + 1, memory_order_release);
+
+    return STMLIBS_OK;
+}
+
+STMLIBS_StatusTypeDef CIRCULAR_BUFFER_MPSC_dequeue(CIRCULAR_BUFFER_MPSC_HandleTypeDef *handle, void *obj) {
+    if (handle == NULL || obj == NULL) {
+        return STMLIBS_ERROR;
+    }
+
+    void *element = CIRCULAR_BUFFER_MPSC_peek(handle);
+
+    if (element == NULL) {
+        return STMLIBS_ERROR;
+    }
+
+    memcpy(obj, element, handle->size);
+
+    return CIRCULAR_BUFFER_MPSC_release(handle);
+}
+
+void *CIRCULAR_BUFFER_MPSC_peek(CIRCULAR_BUFFER_MPSC_HandleTypeDef *handle) {
+    if (handle == NULL) {
+        return NULL;
+    }
+
+    uint32_t pos = handle->tail;
+
+    if (atomic_load_explicit(&handle->sequences[pos & handle->mask], memory_order_acquire) != pos + 1) {
+        return NULL;
+    }
+
+    return handle->buffer + (pos & handle->mask) * handle->size;
+}
+
+STMLIBS_StatusTypeDef CIRCULAR_BUFFER_MPSC_release(CIRCULAR_BUFFER_MPSC_HandleTypeDef *handle) {
+    if (handle == NULL) {
+        return STMLIBS_ERROR;
+    }
+
+    uint32_t pos                                   = handle->tail;
+    CIRCULAR_BUFFER_MPSC_SequenceTypeDef *sequence = &handle->sequences[pos & handle->mask];
+
+    if (atomic_load_explicit(sequence, memory_order_acquire) != pos + 1) {
+        return STMLIBS_ERROR;
+    }
+
+    // Hand the slot back to the producers for the next lap
+    atomic_store_explicit(sequence, pos + handle->mask + 1, memory_order_release);
+    handle->tail = pos + 1;
+
+    return STMLIBS_OK;
+}
+
+uint8_t CIRCULAR_BUFFER_MPSC_is_empty(CIRCULAR_BUFFER_MPSC_HandleTypeDef *handle) {
+    if (handle == NULL) {
+        return 1;
+    }
+
+    uint32_t pos = handle->tail;
+
+    return atomic_load_explicit(&handle->sequences[pos & handle->mask], memory_order_acquire) != pos + 1;
+}
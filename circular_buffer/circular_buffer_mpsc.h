@@ -0,0 +1,102 @@
+/*
+ * "THE BEER-WARE LICENSE" (Revision 69):
+ * Squadra Corse firmware team wrote this file. As long as you retain this notice
+ * you can do whatever you want with this stuff. If we meet some day, and you
+ * think this stuff is worth it, you can buy us a beer in return.
+ *
+ * Authors
+ * - Federico Carbone [federico.carbone.sc@gmail.com]
+ */
+
+/*
+ * Lock-free multi-producer/single-consumer circular buffer.
+ *
+ * Any number of contexts (e.g. ISRs at different NVIC priorities) enqueue,
+ * one context (e.g. the main loop) dequeues, no critical section is needed.
+ *
+ * Every slot carries a sequence number telling whether it is free for the
+ * producer claiming position pos (sequence == pos) or holds the element
+ * published at pos (sequence == pos + 1). Producers claim a position with a
+ * compare-and-swap on head, so a preempting higher priority producer never
+ * waits for a lower priority one: it simply claims the next slot. The consumer
+ * stops at a slot claimed but not yet published.
+ *
+ * Requires C11 atomics with compare-and-swap on 32 bit words (Cortex-M3 and
+ * above, or any host). length must be a power of two, at least 2.
+ */
+
+#ifndef CIRCULAR_BUFFER_MPSC_H
+#define CIRCULAR_BUFFER_MPSC_H
+
+#include "main.h"
+#include "stmlibs_status.h"
+
+#include <inttypes.h>
+#include <stdatomic.h>
+
+typedef atomic_uint_least32_t CIRCULAR_BUFFER_MPSC_SequenceTypeDef;
+
+struct CIRCULAR_BUFFER_MPSC_HandleStruct {
+    uint8_t *buffer;
+    CIRCULAR_BUFFER_MPSC_SequenceTypeDef *sequences;
+    uint32_t mask;
+    uint32_t size;
+    atomic_uint_least32_t head;
+    uint32_t tail;
+};
+typedef struct CIRCULAR_BUFFER_MPSC_HandleStruct CIRCULAR_BUFFER_MPSC_HandleTypeDef;
+
+/**
+ * @brief     Initialize a CIRCULAR_BUFFER_MPSC_HandleTypeDef structure
+ *
+ * @param     handle Reference to the struct to be initialized
+ * @param     buffer Storage of at least length * el_size bytes
+ * @param     sequences Array of length sequence numbers, one per slot
+ * @param     length Number of elements, must be a power of two of at least 2
+ * @param     el_size Size of a single element in bytes
+ * @return    STMLIBS_OK on success, STMLIBS_ERROR on failure
+ */
+STMLIBS_StatusTypeDef CIRCULAR_BUFFER_MPSC_init(CIRCULAR_BUFFER_MPSC_HandleTypeDef *handle,
+                                                void *buffer,
+                                                CIRCULAR_BUFFER_MPSC_SequenceTypeDef *sequences,
+                                                uint32_t length,
+                                                uint32_t el_size);
+/**
+ * @brief     Copy obj in the buffer, can be called concurrently by any producer
+ *
+ * @param     handle Reference to the handle
+ * @param     obj Element to be copied
+ * @return    STMLIBS_OK on success, STMLIBS_ERROR if the buffer is full
+ */
+STMLIBS_StatusTypeDef CIRCULAR_BUFFER_MPSC_enqueue(CIRCULAR_BUFFER_MPSC_HandleTypeDef *handle, const void *obj);
+/**
+ * @brief     Remove the oldest element from the buffer, to be called only by the consumer
+ *
+ * @param     handle Reference to the handle
+ * @param     obj Destination of the element
+ * @return    STMLIBS_OK on success, STMLIBS_ERROR if no published element is available
+ */
+STMLIBS_StatusTypeDef CIRCULAR_BUFFER_MPSC_dequeue(CIRCULAR_BUFFER_MPSC_HandleTypeDef *handle, void *obj);
+/**
+ * @brief     Get the oldest published element in place, to be called only by the consumer
+ *
+ * @param     handle Reference to the handle
+ * @return    pointer to the element, NULL if no published element is available
+ */
+void *CIRCULAR_BUFFER_MPSC_peek(CIRCULAR_BUFFER_MPSC_HandleTypeDef *handle);
+/**
+ * @brief     Hand the element returned by @CIRCULAR_BUFFER_MPSC_peek back to the producers
+ *
+ * @param     handle Reference to the handle
+ * @return    STMLIBS_OK on success, STMLIBS_ERROR if no published element is available
+ */
+STMLIBS_StatusTypeDef CIRCULAR_BUFFER_MPSC_release(CIRCULAR_BUFFER_MPSC_HandleTypeDef *handle);
+/**
+ * @brief     Check whether the next element is published, to be called only by the consumer
+ *
+ * @param     handle Reference to the handle
+ * @return    1 if nothing can be dequeued, 0 otherwise
+ */
+uint8_t CIRCULAR_BUFFER_MPSC_is_empty(CIRCULAR_BUFFER_MPSC_HandleTypeDef *handle);
+
+#endif  //CIRCULAR_BUFFER_MPSC_H
@@ -0,0 +1,135 @@
+/*
+ * "THE BEER-WARE LICENSE" (Revision 69):
+ * Squadra Corse firmware team wrote this file. As long as you retain this notice
+ * you can do whatever you want with this stuff. If we meet some day, and you
+ * think this stuff is worth it, you can buy us a beer in return.
+ *
+ * Authors
+ * - Federico Carbone [federico.carbone.sc@gmail.com]
+ */
+
+#include "circular_buffer_spsc.h"
+
+#include <string.h>
+
+STMLIBS_StatusTypeDef CIRCULAR_BUFFER_SPSC_init(CIRCULAR_BUFFER_SPSC_HandleTypeDef *handle,
+                                                void *buffer,
+                                                uint32_t length,
+                                                uint32_t el_size) {
+    if (handle == NULL) {
+        return STMLIBS_ERROR;
+    }
+
+    if (buffer == NULL) {
+        return STMLIBS_ERROR;
+    }
+
+    // The free running counters wrap at 2^32, which is a multiple of length only if it is a power of two
+    if (length == 0 || (length & (length - 1)) != 0) {
+        return STMLIBS_ERROR;
+    }
+
+    handle->buffer = buffer;
+    handle->mask   = length - 1;
+    handle->size   = el_size;
+    atomic_init(&handle->head, 0);
+    atomic_init(&handle->tail, 0);
+
+    return STMLIBS_OK;
+}
+
+STMLIBS_StatusTypeDef CIRCULAR_BUFFER_SPSC_enqueue(CIRCULAR_BUFFER_SPSC_HandleTypeDef *handle, const void *obj) {
+    if (handle == NULL || obj == NULL) {
+        return STMLIBS_ERROR;
+    }
+
+    uint32_t head = atomic_load_explicit(&handle->head, memory_order_relaxed);
+    uint32_t tail = atomic_load_explicit(&handle->tail, memory_order_acquire);
+
+    if (head - tail > handle->mask) {
+        return STMLIBS_ERROR;
+    }
+
+    memcpy(handle->buffer + (head & handle->mask) * handle->size, obj, handle->size);
+    atomic_store_explicit(&handle->head, head + 1, memory_order_release);
+
+    return STMLIBS_OK;
+}
+
+STMLIBS_StatusTypeDef CIRCULAR_BUFFER_SPSC_dequeue(CIRCULAR_BUFFER_SPSC_HandleTypeDef *handle, void *obj) {
+    if (handle == NULL || obj == NULL) {
+        return STMLIBS_ERROR;
+    }
+
+    uint32_t tail = atomic_load_explicit(&handle->tail, memory_order_relaxed);
+    uint32_t head = atomic_load_explicit(&handle->head, memory_order_acquire);
+
+    if (head == tail) {
+        return STMLIBS_ERROR;
+    }
+
+    memcpy(obj, handle->buffer + (tail & handle->mask) * handle->size, handle->size);
+    atomic_store_explicit(&handle->tail, tail + 1, memory_order_release);
+
+    return STMLIBS_OK;
+}
+
+uint32_t CIRCULAR_BUFFER_SPSC_peek(CIRCULAR_BUFFER_SPSC_HandleTypeDef *handle, void **span) {
+    if (handle == NULL || span == NULL) {
+        return 0;
+    }
+
+    uint32_t tail = atomic_load_explicit(&handle->tail, memory_order_relaxed);
+    uint32_t head = atomic_load_explicit(&handle->head, memory_order_acquire);
+
+    uint32_t count      = head - tail;
+    uint32_t contiguous = handle->mask + 1 - (tail & handle->mask);
+
+    *span = handle->buffer + (tail & handle->mask) * handle->size;
+
+    return contiguous < count ? contiguous : count;
+}
+
+STMLIBS_StatusTypeDef CIRCULAR_BUFFER_SPSC_release(CIRCULAR_BUFFER_SPSC_HandleTypeDef *handle, uint32_t n) {
+    if (handle == NULL) {
+        return STMLIBS_ERROR;
+    }
+
+    uint32_t tail = atomic_load_explicit(&handle->tail, memory_order_relaxed);
+    uint32_t head = atomic_load_explicit(&handle->head, memory_order_acquire);
+
+    if (n > head - tail) {
+        return STMLIBS_ERROR;
+    }
+
+    atomic_store_explicit(&handle->tail, tail + n, memory_order_release);
+
+    return STMLIBS_OK;
+}
+
+uint32_t CIRCULAR_BUFFER_SPSC_count(CIRCULAR_BUFFER_SPSC_HandleTypeDef *handle) {
+    if (handle == NULL) {
+        return 0;
+    }
+
+    uint32_t tail = atomic_load_explicit(&handle->tail, memory_order_acquire);
+    uint32_t head = atomic_load_explicit(&handle->head, memory_order_acquire);
+
+    return head - tail;
+}
+
+uint8_t CIRCULAR_BUFFER_SPSC_is_full(CIRCULAR_BUFFER_SPSC_HandleTypeDef *handle) {
+    if (handle == NULL) {
+        return 1;
+    }
+
+    return CIRCULAR_BUFFER_SPSC_count(handle) > handle->mask;
+}
+
+uint8_t CIRCULAR_BUFFER_SPSC_is_empty(CIRCULAR_BUFFER_SPSC_HandleTypeDef *handle) {
+    if (handle == NULL) {
+        return 1;
+    }
+
+    return CIRCULAR_BUFFER_SPSC_count(handle) == 0;
+}
@@ -0,0 +1,102 @@
+/*
+ * "THE BEER-WARE LICENSE" (Revision 69):
+ * Squadra Corse firmware team wrote this file. As long as you retain this notice
+ * you can do whatever you want with this stuff. If we meet some day, and you
+ * think this stuff is worth it, you can buy us a beer in return.
+ *
+ * Authors
+ * - Federico Carbone [federico.carbone.sc@gmail.com]
+ */
+
+/*
+ * Lock-free single-producer/single-consumer circular buffer.
+ *
+ * One context (e.g. an ADC/UART ISR) enqueues, another one (e.g. the main
+ * loop) dequeues: no CS_ENTER()/CS_EXIT() is needed around the calls.
+ *
+ * head and tail are free running counters, only the producer writes head and
+ * only the consumer writes tail. The slot index is obtained masking the
+ * counter, so the length must be a power of two and all the slots are usable.
+ * Data is published with a release store on the counter and observed with an
+ * acquire load on the other side.
+ *
+ * Requires C11 atomics on 32 bit words (Cortex-M3 and above, or any host).
+ */
+
+#ifndef CIRCULAR_BUFFER_SPSC_H
+#define CIRCULAR_BUFFER_SPSC_H
+
+#include "main.h"
+#include "stmlibs_status.h"
+
+#include <inttypes.h>
+#include <stdatomic.h>
+
+struct CIRCULAR_BUFFER_SPSC_HandleStruct {
+    uint8_t *buffer;
+    uint32_t mask;
+    uint32_t size;
+    atomic_uint_least32_t head;
+    atomic_uint_least32_t tail;
+};
+typedef struct CIRCULAR_BUFFER_SPSC_HandleStruct CIRCULAR_BUFFER_SPSC_HandleTypeDef;
+
+/**
+ * @brief     Initialize a CIRCULAR_BUFFER_SPSC_HandleTypeDef structure
+ *
+ * @param     handle Reference to the struct to be initialized
+ * @param     buffer Storage of at least length * el_size bytes
+ * @param     length Number of elements, must be a power of two
+ * @param     el_size Size of a single element in bytes
+ * @return    STMLIBS_OK on success, STMLIBS_ERROR on failure
+ */
+STMLIBS_StatusTypeDef CIRCULAR_BUFFER_SPSC_init(CIRCULAR_BUFFER_SPSC_HandleTypeDef *handle,
+                                                void *buffer,
+                                                uint32_t length,
+                                                uint32_t el_size);
+/**
+ * @brief     Copy obj in the buffer, to be called only by the producer
+ *
+ * @param     handle Reference to the handle
+ * @param     obj Element to be copied
+ * @return    STMLIBS_OK on success, STMLIBS_ERROR if the buffer is full
+ */
+STMLIBS_StatusTypeDef CIRCULAR_BUFFER_SPSC_enqueue(CIRCULAR_BUFFER_SPSC_HandleTypeDef *handle, const void *obj);
+/**
+ * @brief     Remove the oldest element from the buffer, to be called only by the consumer
+ *
+ * @param     handle Reference to the handle
+ * @param     obj Destination of the element
+ * @return    STMLIBS_OK on success, STMLIBS_ERROR if the buffer is empty
+ */
+STMLIBS_StatusTypeDef CIRCULAR_BUFFER_SPSC_dequeue(CIRCULAR_BUFFER_SPSC_HandleTypeDef *handle, void *obj);
+/**
+ * @brief     Get the oldest element in place, to be called only by the consumer
+ *
+ * @param     handle Reference to the handle
+ * @param     span Set to the oldest element
+ * @return    number of contiguous readable elements starting at span
+ */
+uint32_t CIRCULAR_BUFFER_SPSC_peek(CIRCULAR_BUFFER_SPSC_HandleTypeDef *handle, void **span);
+/**
+ * @brief     Drop n elements returned by @CIRCULAR_BUFFER_SPSC_peek, to be called only by the consumer
+ *
+ * @param     handle Reference to the handle
+ * @param     n Number of elements processed
+ * @return    STMLIBS_OK on success, STMLIBS_ERROR if n exceeds the stored elements
+ */
+STMLIBS_StatusTypeDef CIRCULAR_BUFFER_SPSC_release(CIRCULAR_BUFFER_SPSC_HandleTypeDef *handle, uint32_t n);
+/**
+ * @brief     Number of elements currently stored: a lower bound when called
+ *                by the consumer, an upper bound when called by the producer
+ *
+ * @param     handle Reference to the handle
+ * @return    number of elements
+ */
+uint32_t CIRCULAR_BUFFER_SPSC_count(CIRCULAR_BUFFER_SPSC_HandleTypeDef *handle);
+
+uint8_t CIRCULAR_BUFFER_SPSC_is_full(CIRCULAR_BUFFER_SPSC_HandleTypeDef *handle);
+
+uint8_t CIRCULAR_BUFFER_SPSC_is_empty(CIRCULAR_BUFFER_SPSC_HandleTypeDef *handle);
+
+#endif  //CIRCULAR_BUFFER_SPSC_H
@@ -0,0 +1,80 @@
+/*
+ * "THE BEER-WARE LICENSE" (Revision 69):
+ * Squadra Corse firmware team wrote this file. As long as you retain this notice
+ * you can do whatever you want with this stuff. If we meet some day, and you
+ * think this stuff is worth it, you can buy us a beer in return.
+ *
+ * Authors
+ * - Federico Carbone [federico.carbone.sc@gmail.com]
+ */
+
+/*
+ * Cost per element of moving 8 byte frames through a CIRCULAR_BUFFER one call
+ * per element (enqueue/dequeue) against bulk transfers (enqueue_n/dequeue_n)
+ * of several sizes. The buffer length is not a multiple of the burst, so the
+ * bulk copies also cross the wrap point.
+ */
+
+#include "circular_buffer.h"
+#include "host.h"
+
+#define LENGTH 1000
+#define FRAMES 20000000U
+
+struct Frame {
+    uint32_t id;
+    uint8_t data[4];
+};
+
+static struct Frame storage[LENGTH];
+static struct Frame burst[256];
+static CIRCULAR_BUFFER_HandleTypeDef hbuf;
+
+static double single(void) {
+    uint64_t start = host_ns();
+    uint32_t sum   = 0;
+
+    for (uint32_t i = 0; i < FRAMES; ++i) {
+        struct Frame frame = {.id = i};
+        CIRCULAR_BUFFER_enqueue(&hbuf, &frame);
+        HOST_CHECK(CIRCULAR_BUFFER_dequeue(&hbuf, &frame) == STMLIBS_OK);
+        sum += frame.id;
+    }
+
+    HOST_CHECK(sum == (uint32_t)((uint64_t)FRAMES * (FRAMES - 1) / 2));
+    return (double)(host_ns() - start) / FRAMES;
+}
+
+static double bulk(uint32_t n) {
+    uint64_t start = host_ns();
+    uint32_t sum   = 0;
+
+    for (uint32_t i = 0; i < FRAMES; i += n) {
+        for (uint32_t j = 0; j < n; ++j) {
+            burst[j].id = i + j;
+        }
+        HOST_CHECK(CIRCULAR_BUFFER_enqueue_n(&hbuf, burst, n) == n);
+        HOST_CHECK(CIRCULAR_BUFFER_dequeue_n(&hbuf, burst, n) == n);
+        for (uint32_t j = 0; j < n; ++j) {
+            sum += burst[j].id;
+        }
+    }
+
+    HOST_CHECK(sum == (uint32_t)((uint64_t)FRAMES * (FRAMES - 1) / 2));
+    return (double)(host_ns() - start) / FRAMES;
+}
+
+int main(void) {
+    HOST_CHECK(CIRCULAR_BUFFER_init(&hbuf, storage, LENGTH, sizeof(struct Frame)) == STMLIBS_OK);
+
+    printf("%-24s %8.2f ns/frame\n", "enqueue + dequeue", single());
+
+    static const uint32_t sizes[] = {1, 8, 32, 256};
+    for (uint32_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); ++i) {
+        char name[32];
+        snprintf(name, sizeof(name), "enqueue_n/dequeue_n %" PRIu32, sizes[i]);
+        printf("%-24s %8.2f ns/frame\n", name, bulk(sizes[i]));
+    }
+
+    return 0;
+}
@@ -0,0 +1,86 @@
+/*
+ * "THE BEER-WARE LICENSE" (Revision 69):
+ * Squadra Corse firmware team wrote this file. As long as you retain this notice
+ * you can do whatever you want with this stuff. If we meet some day, and you
+ * think this stuff is worth it, you can buy us a beer in return.
+ *
+ * Authors
+ * - Federico Carbone [federico.carbone.sc@gmail.com]
+ */
+
+/*
+ * Cycles per push/pop of 12 byte frames on a 64 slot buffer: CIRCBUF_DECL
+ * against CIRCULAR_BUFFER, filling and draining half of the buffer so that the
+ * slots wrap.
+ */
+
+#include "circular_buffer.h"
+#include "circular_buffer_gen.h"
+#include "host.h"
+
+#define ROUNDS 1000000U
+#define BURST  32U
+
+struct Frame {
+    uint32_t id;
+    uint8_t data[8];
+};
+
+CIRCBUF_DECL(struct Frame, frame, 64);
+
+static struct CIRCBUF_Handle_frame hframe;
+
+static struct Frame storage[64];
+static CIRCULAR_BUFFER_HandleTypeDef hbuf;
+
+static double typed(void) {
+    uint32_t sum   = 0;
+    uint64_t start = host_cycles();
+
+    for (uint32_t round = 0; round < ROUNDS; ++round) {
+        for (uint32_t i = 0; i < BURST; ++i) {
+            struct Frame frame = {.id = i};
+            CIRCBUF_Push_frame(&hframe, frame);
+        }
+        for (uint32_t i = 0; i < BURST; ++i) {
+            struct Frame frame;
+            HOST_CHECK(CIRCBUF_Pop_frame(&hframe, &frame) == 0);
+            sum += frame.id;
+        }
+    }
+
+    double cycles = (double)(host_cycles() - start) / (ROUNDS * BURST * 2);
+    HOST_CHECK(sum == ROUNDS * (BURST * (BURST - 1) / 2));
+    return cycles;
+}
+
+static double generic(void) {
+    uint32_t sum   = 0;
+    uint64_t start = host_cycles();
+
+    for (uint32_t round = 0; round < ROUNDS; ++round) {
+        for (uint32_t i = 0; i < BURST; ++i) {
+            struct Frame frame = {.id = i};
+            CIRCULAR_BUFFER_enqueue(&hbuf, &frame);
+        }
+        for (uint32_t i = 0; i < BURST; ++i) {
+            struct Frame frame;
+            HOST_CHECK(CIRCULAR_BUFFER_dequeue(&hbuf, &frame) == STMLIBS_OK);
+            sum += frame.id;
+        }
+    }
+
+    double cycles = (double)(host_cycles() - start) / (ROUNDS * BURST * 2);
+    HOST_CHECK(sum == ROUNDS * (BURST * (BURST - 1) / 2));
+    return cycles;
+}
+
+int main(void) {
+    CIRCBUF_Init_frame(&hframe);
+    HOST_CHECK(CIRCULAR_BUFFER_init(&hbuf, storage, 64, sizeof(struct Frame)) == STMLIBS_OK);
+
+    printf("%-16s %6.1f cycles/op\n", "CIRCBUF_DECL", typed());
+    printf("%-16s %6.1f cycles/op\n", "CIRCULAR_BUFFER", generic());
+
+    return 0;
+}
@@ -0,0 +1,138 @@
+/*
+ * "THE BEER-WARE LICENSE" (Revision 69):
+ * Squadra Corse firmware team wrote this file. As long as you retain this notice
+ * you can do whatever you want with this stuff. If we meet some day, and you
+ * think this stuff is worth it, you can buy us a beer in return.
+ *
+ * Authors
+ * - Federico Carbone [federico.carbone.sc@gmail.com]
+ */
+
+/*
+ * CIRCBUF_DECL buffers: fill, drain, wrap of the slots and of the free running
+ * counters, and a random push/pop sequence checked against a plain array.
+ */
+
+#include "circular_buffer_gen.h"
+#include "host.h"
+
+#include <string.h>
+
+struct Frame {
+    uint32_t id;
+    uint8_t data[8];
+};
+
+CIRCBUF_DECL(struct Frame, frame, 64);
+CIRCBUF_DECL(uint8_t, byte, 1);
+
+static struct CIRCBUF_Handle_frame hframe;
+static struct CIRCBUF_Handle_byte hbyte;
+
+static struct Frame frame_of(uint32_t id) {
+    struct Frame frame = {.id = id};
+    for (uint32_t i = 0; i < sizeof(frame.data); ++i) {
+        frame.data[i] = (uint8_t)(id + i);
+    }
+    return frame;
+}
+
+static void check_frame(struct Frame frame, uint32_t id) {
+    struct Frame expected = frame_of(id);
+    HOST_CHECK(frame.id == expected.id);
+    HOST_CHECK(memcmp(frame.data, expected.data, sizeof(frame.data)) == 0);
+}
+
+static void fill_drain(void) {
+    struct Frame frame;
+
+    CIRCBUF_Init_frame(&hframe);
+    HOST_CHECK(CIRCBUF_IsEmpty_frame(&hframe));
+    HOST_CHECK(CIRCBUF_Pop_frame(&hframe, &frame) == -1);
+
+    // All the 64 slots are usable
+    for (uint32_t i = 0; i < 64; ++i) {
+        HOST_CHECK(CIRCBUF_Push_frame(&hframe, frame_of(i)) == 0);
+        HOST_CHECK(CIRCBUF_Count_frame(&hframe) == i + 1);
+    }
+    HOST_CHECK(CIRCBUF_IsFull_frame(&hframe));
+    HOST_CHECK(CIRCBUF_Push_frame(&hframe, frame_of(64)) == -1);
+
+    for (uint32_t i = 0; i < 64; ++i) {
+        HOST_CHECK(CIRCBUF_Pop_frame(&hframe, &frame) == 0);
+        check_frame(frame, i);
+    }
+    HOST_CHECK(CIRCBUF_IsEmpty_frame(&hframe));
+}
+
+static void counter_wrap(void) {
+    struct Frame frame;
+
+    // The counters overflow while elements are stored
+    CIRCBUF_Init_frame(&hframe);
+    hframe.head = UINT32_MAX - 10;
+    hframe.tail = UINT32_MAX - 10;
+
+    for (uint32_t i = 0; i < 40; ++i) {
+        HOST_CHECK(CIRCBUF_Push_frame(&hframe, frame_of(i)) == 0);
+    }
+    HOST_CHECK(CIRCBUF_Count_frame(&hframe) == 40);
+    for (uint32_t i = 0; i < 40; ++i) {
+        HOST_CHECK(CIRCBUF_Pop_frame(&hframe, &frame) == 0);
+        check_frame(frame, i);
+    }
+    HOST_CHECK(CIRCBUF_IsEmpty_frame(&hframe));
+}
+
+static void single_slot(void) {
+    uint8_t byte;
+
+    CIRCBUF_Init_byte(&hbyte);
+    HOST_CHECK(CIRCBUF_Push_byte(&hbyte, 7) == 0);
+    HOST_CHECK(CIRCBUF_IsFull_byte(&hbyte));
+    HOST_CHECK(CIRCBUF_Push_byte(&hbyte, 8) == -1);
+    HOST_CHECK(CIRCBUF_Pop_byte(&hbyte, &byte) == 0 && byte == 7);
+    HOST_CHECK(CIRCBUF_Pop_byte(&hbyte, &byte) == -1);
+}
+
+static void random_sequence(void) {
+    static uint32_t reference[64];
+    uint32_t first = 0, stored = 0, next = 0;
+    uint32_t seed = 12345;
+
+    CIRCBUF_Init_frame(&hframe);
+    for (uint32_t step = 0; step < 1000000; ++step) {
+        seed = seed * 1103515245U + 12345U;
+
+        if ((seed >> 16) & 1) {
+            int ret = CIRCBUF_Push_frame(&hframe, frame_of(next));
+            HOST_CHECK(ret == (stored == 64 ? -1 : 0));
+            if (ret == 0) {
+                reference[(first + stored++) % 64] = next;
+            }
+            ++next;
+        } else {
+            struct Frame frame;
+            int ret = CIRCBUF_Pop_frame(&hframe, &frame);
+            HOST_CHECK(ret == (stored == 0 ? -1 : 0));
+            if (ret == 0) {
+                check_frame(frame, reference[first]);
+                first = (first + 1) % 64;
+                --stored;
+            }
+        }
+
+        HOST_CHECK(CIRCBUF_Count_frame(&hframe) == stored);
+    }
+}
+
+int main(void) {
+    fill_drain();
+    counter_wrap();
+    single_slot();
+    random_sequence();
+
+    printf("gen_test: ok\n");
+
+    return 0;
+}
@@ -0,0 +1,167 @@
+/*
+ * "THE BEER-WARE LICENSE" (Revision 69):
+ * Squadra Corse firmware team wrote this file. As long as you retain this notice
+ * you can do whatever you want with this stuff. If we meet some day, and you
+ * think this stuff is worth it, you can buy us a beer in return.
+ *
+ * Authors
+ * - Federico Carbone [federico.carbone.sc@gmail.com]
+ */
+
+/*
+ * Three producer threads, standing for the ISRs of the boards, and one
+ * consumer thread share a small MPSC buffer. Every element carries its
+ * producer, its sequence number within that producer and a checksum of both:
+ * the consumer fails the test on a lost, duplicated, reordered or torn
+ * element. The consumer alternates dequeue and peek/release.
+ */
+
+#include "circular_buffer_mpsc.h"
+#include "host.h"
+
+#include <pthread.h>
+#include <sched.h>
+
+#define LENGTH    16
+#define PRODUCERS 3
+#define ELEMENTS  1000000U
+
+struct Element {
+    uint32_t producer;
+    uint32_t sequence;
+    uint32_t check;
+    uint32_t padding[5];
+};
+
+static struct Element storage[LENGTH];
+static CIRCULAR_BUFFER_MPSC_SequenceTypeDef sequences[LENGTH];
+static CIRCULAR_BUFFER_MPSC_HandleTypeDef hbuf;
+
+static uint32_t check_of(uint32_t producer, uint32_t sequence) {
+    return (sequence * 2654435761U) ^ (producer * 0x9E3779B9U) ^ 0xA5A5A5A5U;
+}
+
+static void *producer(void *arg) {
+    uint32_t id = (uint32_t)(uintptr_t)arg;
+
+    for (uint32_t i = 0; i < ELEMENTS; ++i) {
+        struct Element element = {.producer = id, .sequence = i, .check = check_of(id, i)};
+        for (uint32_t j = 0; j < 5; ++j) {
+            element.padding[j] = element.check + j;
+        }
+
+        // Yield when full, the test must also progress on a single core
+        while (CIRCULAR_BUFFER_MPSC_enqueue(&hbuf, &element) != STMLIBS_OK) {
+            sched_yield();
+        }
+    }
+
+    return NULL;
+}
+
+static uint32_t expected[PRODUCERS];
+
+static void check_element(const struct Element *element) {
+    HOST_CHECK(element->producer < PRODUCERS);
+    HOST_CHECK(element->sequence == expected[element->producer]);
+    HOST_CHECK(element->check == check_of(element->producer, element->sequence));
+    for (uint32_t j = 0; j < 5; ++j) {
+        HOST_CHECK(element->padding[j] == element->check + j);
+    }
+    ++expected[element->producer];
+}
+
+static void *consumer(void *arg) {
+    (void)arg;
+
+    for (uint32_t received = 0; received < PRODUCERS * ELEMENTS;) {
+        if (received & 1) {
+            struct Element element;
+            if (CIRCULAR_BUFFER_MPSC_dequeue(&hbuf, &element) == STMLIBS_OK) {
+                check_element(&element);
+                ++received;
+            } else {
+                sched_yield();
+            }
+        } else {
+            struct Element *element = CIRCULAR_BUFFER_MPSC_peek(&hbuf);
+            if (element != NULL) {
+                check_element(element);
+                HOST_CHECK(CIRCULAR_BUFFER_MPSC_release(&hbuf) == STMLIBS_OK);
+                ++received;
+            } else {
+                sched_yield();
+            }
+        }
+    }
+
+    return NULL;
+}
+
+int main(void) {
+    HOST_CHECK(CIRCULAR_BUFFER_MPSC_init(&hbuf, storage, sequences, 12, sizeof(struct Element)) == STMLIBS_ERROR);
+    HOST_CHECK(CIRCULAR_BUFFER_MPSC_init(&hbuf, storage, sequences, 1, sizeof(struct Element)) == STMLIBS_ERROR);
+    HOST_CHECK(CIRCULAR_BUFFER_MPSC_init(&hbuf, storage, sequences, 0, sizeof(struct Element)) == STMLIBS_ERROR);
+
+    // The smallest queue: full after two elements, then empty again
+    struct Element small = {0};
+    HOST_CHECK(CIRCULAR_BUFFER_MPSC_init(&hbuf, storage, sequences, 2, sizeof(struct Element)) == STMLIBS_OK);
+    for (uint32_t lap = 0; lap < 3; ++lap) {
+        small.sequence = 1;
+        HOST_CHECK(CIRCULAR_BUFFER_MPSC_enqueue(&hbuf, &small) == STMLIBS_OK);
+        small.sequence = 2;
+        HOST_CHECK(CIRCULAR_BUFFER_MPSC_enqueue(&hbuf, &small) == STMLIBS_OK);
+        HOST_CHECK(CIRCULAR_BUFFER_MPSC_enqueue(&hbuf, &small) == STMLIBS_ERROR);
+        HOST_CHECK(CIRCULAR_BUFFER_MPSC_dequeue(&hbuf, &small) == STMLIBS_OK && small.sequence == 1);
+        HOST_CHECK(CIRCULAR_BUFFER_MPSC_dequeue(&hbuf, &small) == STMLIBS_OK && small.sequence == 2);
+        HOST_CHECK(CIRCULAR_BUFFER_MPSC_dequeue(&hbuf, &small) == STMLIBS_ERROR);
+    }
+
+    HOST_CHECK(CIRCULAR_BUFFER_MPSC_init(&hbuf, storage, sequences, LENGTH, sizeof(struct Element)) == STMLIBS_OK);
+
+    // Every function rejects a NULL handle
+    struct Element element = {0};
+    HOST_CHECK(CIRCULAR_BUFFER_MPSC_init(NULL, storage, sequences, LENGTH, sizeof(element)) == STMLIBS_ERROR);
+    HOST_CHECK(CIRCULAR_BUFFER_MPSC_enqueue(NULL, &element) == STMLIBS_ERROR);
+    HOST_CHECK(CIRCULAR_BUFFER_MPSC_enqueue(&hbuf, NULL) == STMLIBS_ERROR);
+    HOST_CHECK(CIRCULAR_BUFFER_MPSC_dequeue(NULL, &element) == STMLIBS_ERROR);
+    HOST_CHECK(CIRCULAR_BUFFER_MPSC_dequeue(&hbuf, NULL) == STMLIBS_ERROR);
+    HOST_CHECK(CIRCULAR_BUFFER_MPSC_peek(NULL) == NULL);
+    HOST_CHECK(CIRCULAR_BUFFER_MPSC_release(NULL) == STMLIBS_ERROR);
+    HOST_CHECK(CIRCULAR_BUFFER_MPSC_is_empty(NULL) == 1);
+
+    // All the slots are usable, an empty buffer has nothing to release
+    HOST_CHECK(CIRCULAR_BUFFER_MPSC_release(&hbuf) == STMLIBS_ERROR);
+    for (uint32_t i = 0; i < LENGTH; ++i) {
+        HOST_CHECK(CIRCULAR_BUFFER_MPSC_enqueue(&hbuf, &element) == STMLIBS_OK);
+    }
+    HOST_CHECK(CIRCULAR_BUFFER_MPSC_enqueue(&hbuf, &element) == STMLIBS_ERROR);
+    for (uint32_t i = 0; i < LENGTH; ++i) {
+        HOST_CHECK(CIRCULAR_BUFFER_MPSC_dequeue(&hbuf, &element) == STMLIBS_OK);
+    }
+    HOST_CHECK(CIRCULAR_BUFFER_MPSC_is_empty(&hbuf));
+
+    pthread_t threads[PRODUCERS + 1];
+    uint64_t start = host_ns();
+    for (uint32_t i = 0; i < PRODUCERS; ++i) {
+        pthread_create(&threads[i], NULL, producer, (void *)(uintptr_t)i);
+    }
+    pthread_create(&threads[PRODUCERS], NULL, consumer, NULL);
+    for (uint32_t i = 0; i < PRODUCERS + 1; ++i) {
+        pthread_join(threads[i], NULL);
+    }
+    double seconds = (host_ns() - start) / 1e9;
+
+    for (uint32_t i = 0; i < PRODUCERS; ++i) {
+        HOST_CHECK(expected[i] == ELEMENTS);
+    }
+    HOST_CHECK(CIRCULAR_BUFFER_MPSC_is_empty(&hbuf));
+    printf("mpsc_stress: %u elements from %u producers through %u slots in %.2f s (%.1f Mop/s)\n",
+           PRODUCERS * ELEMENTS,
+           PRODUCERS,
+           LENGTH,
+           seconds,
+           PRODUCERS * ELEMENTS / seconds / 1e6);
+
+    return 0;
+}
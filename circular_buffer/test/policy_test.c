@@ -0,0 +1,171 @@
+/*
+ * "THE BEER-WARE LICENSE" (Revision 69):
+ * Squadra Corse firmware team wrote this file. As long as you retain this notice
+ * you can do whatever you want with this stuff. If we meet some day, and you
+ * think this stuff is worth it, you can buy us a beer in return.
+ *
+ * Authors
+ * - Federico Carbone [federico.carbone.sc@gmail.com]
+ */
+
+/*
+ * Full buffer policies of CIRCULAR_BUFFER and its occupancy counters: the
+ * reject policy keeps the oldest elements, the overwrite one the newest, with
+ * enqueue and enqueue_n, and high_water, dropped and enqueued follow a
+ * reference model over a random sequence of both policies.
+ */
+
+#include "circular_buffer.h"
+#include "host.h"
+
+#define LENGTH   8
+#define CAPACITY (LENGTH - 1)
+
+static uint32_t storage[LENGTH];
+static CIRCULAR_BUFFER_HandleTypeDef hbuf;
+
+static void check_stats(uint32_t high_water, uint32_t dropped, uint32_t enqueued) {
+    CIRCULAR_BUFFER_StatsTypeDef stats;
+
+    HOST_CHECK(CIRCULAR_BUFFER_get_stats(&hbuf, &stats) == STMLIBS_OK);
+    HOST_CHECK(stats.high_water == high_water);
+    HOST_CHECK(stats.dropped == dropped);
+    HOST_CHECK(stats.enqueued == enqueued);
+}
+
+static void check_contents(uint32_t first, uint32_t count) {
+    uint32_t value;
+
+    HOST_CHECK(CIRCULAR_BUFFER_count(&hbuf) == count);
+    for (uint32_t i = 0; i < count; ++i) {
+        HOST_CHECK(CIRCULAR_BUFFER_dequeue(&hbuf, &value) == STMLIBS_OK);
+        HOST_CHECK(value == first + i);
+    }
+    HOST_CHECK(CIRCULAR_BUFFER_is_empty(&hbuf));
+}
+
+static void reject_new(void) {
+    uint32_t values[20];
+    for (uint32_t i = 0; i < 20; ++i) {
+        values[i] = i;
+    }
+
+    HOST_CHECK(CIRCULAR_BUFFER_init(&hbuf, storage, LENGTH, sizeof(uint32_t)) == STMLIBS_OK);
+    check_stats(0, 0, 0);
+
+    for (uint32_t i = 0; i < 10; ++i) {
+        HOST_CHECK(CIRCULAR_BUFFER_enqueue(&hbuf, &values[i]) == (i < CAPACITY ? STMLIBS_OK : STMLIBS_ERROR));
+    }
+    check_stats(CAPACITY, 3, CAPACITY);
+    check_contents(0, CAPACITY);
+
+    HOST_CHECK(CIRCULAR_BUFFER_enqueue_n(&hbuf, values, 20) == CAPACITY);
+    check_stats(CAPACITY, 3 + 20 - CAPACITY, 2 * CAPACITY);
+    check_contents(0, CAPACITY);
+
+    HOST_CHECK(CIRCULAR_BUFFER_reset_stats(&hbuf) == STMLIBS_OK);
+    check_stats(0, 0, 0);
+}
+
+static void overwrite_oldest(void) {
+    uint32_t values[20];
+    for (uint32_t i = 0; i < 20; ++i) {
+        values[i] = i;
+    }
+
+    HOST_CHECK(CIRCULAR_BUFFER_init(&hbuf, storage, LENGTH, sizeof(uint32_t)) == STMLIBS_OK);
+    HOST_CHECK(CIRCULAR_BUFFER_set_policy(&hbuf, CIRCULAR_BUFFER_OVERWRITE_OLDEST) == STMLIBS_OK);
+
+    // The last CAPACITY survive
+    for (uint32_t i = 0; i < 10; ++i) {
+        HOST_CHECK(CIRCULAR_BUFFER_enqueue(&hbuf, &values[i]) == STMLIBS_OK);
+    }
+    check_stats(CAPACITY, 3, 10);
+    check_contents(10 - CAPACITY, CAPACITY);
+
+    // Partly full, then a burst longer than the buffer: only its tail is kept
+    HOST_CHECK(CIRCULAR_BUFFER_enqueue_n(&hbuf, values, 3) == 3);
+    HOST_CHECK(CIRCULAR_BUFFER_enqueue_n(&hbuf, values, 20) == CAPACITY);
+    check_stats(CAPACITY, 3 + 3 + 20 - CAPACITY, 10 + 3 + CAPACITY);
+    check_contents(20 - CAPACITY, CAPACITY);
+
+    // A burst overwriting part of the stored elements
+    HOST_CHECK(CIRCULAR_BUFFER_enqueue_n(&hbuf, values, 5) == 5);
+    HOST_CHECK(CIRCULAR_BUFFER_enqueue_n(&hbuf, &values[5], 5) == 5);
+    check_contents(10 - CAPACITY, CAPACITY);
+}
+
+static void random_sequence(void) {
+    static uint32_t reference[LENGTH];
+    static uint32_t burst[2 * LENGTH];
+    uint32_t first = 0, stored = 0, next = 0;
+    uint32_t high_water = 0, dropped = 0, enqueued = 0;
+    uint32_t seed = 7;
+
+    HOST_CHECK(CIRCULAR_BUFFER_init(&hbuf, storage, LENGTH, sizeof(uint32_t)) == STMLIBS_OK);
+
+    for (uint32_t step = 0; step < 1000000; ++step) {
+        seed              = seed * 1103515245U + 12345U;
+        uint8_t overwrite = (seed >> 24) & 1;
+        uint32_t n        = (seed >> 16) % (2 * LENGTH);
+
+        HOST_CHECK(CIRCULAR_BUFFER_set_policy(
+                       &hbuf, overwrite ? CIRCULAR_BUFFER_OVERWRITE_OLDEST : CIRCULAR_BUFFER_REJECT_NEW) == STMLIBS_OK);
+
+        if ((seed >> 12) & 1) {
+            for (uint32_t i = 0; i < n; ++i) {
+                burst[i] = next + i;
+            }
+            uint32_t accepted = CIRCULAR_BUFFER_enqueue_n(&hbuf, burst, n);
+
+            // Overwriting keeps the newest CAPACITY of the burst and evicts what does not fit, rejecting cuts the burst
+            uint32_t free_space = CAPACITY - stored;
+            uint32_t expected, lost;
+            if (overwrite) {
+                expected = n < CAPACITY ? n : CAPACITY;
+                lost     = n - expected + (expected > free_space ? expected - free_space : 0);
+            } else {
+                expected = n < free_space ? n : free_space;
+                lost     = n - expected;
+            }
+            HOST_CHECK(accepted == expected);
+
+            uint32_t from = overwrite ? n - accepted : 0;
+            for (uint32_t i = from; i < from + accepted; ++i) {
+                if (stored == CAPACITY) {
+                    first = (first + 1) % LENGTH;
+                    --stored;
+                }
+                reference[(first + stored++) % LENGTH] = next + i;
+            }
+            next += n;
+            dropped += lost;
+            enqueued += accepted;
+        } else {
+            for (uint32_t i = 0; i < n && stored > 0; ++i) {
+                uint32_t value;
+                HOST_CHECK(CIRCULAR_BUFFER_dequeue(&hbuf, &value) == STMLIBS_OK);
+                HOST_CHECK(value == reference[first]);
+                first = (first + 1) % LENGTH;
+                --stored;
+            }
+        }
+
+        if (stored > high_water) {
+            high_water = stored;
+        }
+        HOST_CHECK(CIRCULAR_BUFFER_count(&hbuf) == stored);
+    }
+
+    check_stats(high_water, dropped, enqueued);
+}
+
+int main(void) {
+    reject_new();
+    overwrite_oldest();
+    random_sequence();
+
+    printf("policy_test: ok\n");
+
+    return 0;
+}
@@ -0,0 +1,129 @@
+/*
+ * "THE BEER-WARE LICENSE" (Revision 69):
+ * Squadra Corse firmware team wrote this file. As long as you retain this notice
+ * you can do whatever you want with this stuff. If we meet some day, and you
+ * think this stuff is worth it, you can buy us a beer in return.
+ *
+ * Authors
+ * - Federico Carbone [federico.carbone.sc@gmail.com]
+ */
+
+/*
+ * Zero-copy spans of CIRCULAR_BUFFER: reserve/commit and peek/release stop at
+ * the end of the storage and continue from its start, never hand out a slot
+ * outside of it, and reject n beyond the span. A random sequence of spans of
+ * random sizes is checked against the sequence numbers written in place.
+ */
+
+#include "circular_buffer.h"
+#include "host.h"
+
+#define LENGTH 10
+#define GUARD  0xdeadbeefU
+
+/* One guard element on each side of the storage */
+static uint32_t storage[LENGTH + 2];
+static CIRCULAR_BUFFER_HandleTypeDef hbuf;
+
+static void check_span(void *span, uint32_t n) {
+    uint32_t *first = span;
+    HOST_CHECK(n == 0 || (first >= &storage[1] && first + n <= &storage[1 + LENGTH]));
+}
+
+static void wrap(void) {
+    void *span;
+
+    HOST_CHECK(CIRCULAR_BUFFER_init(&hbuf, &storage[1], LENGTH, sizeof(uint32_t)) == STMLIBS_OK);
+
+    // Move head and tail to slot 8
+    HOST_CHECK(CIRCULAR_BUFFER_reserve(&hbuf, &span) == LENGTH - 1);
+    HOST_CHECK(CIRCULAR_BUFFER_commit(&hbuf, 8) == STMLIBS_OK);
+    HOST_CHECK(CIRCULAR_BUFFER_peek(&hbuf, &span) == 8);
+    HOST_CHECK(CIRCULAR_BUFFER_release(&hbuf, 8) == STMLIBS_OK);
+
+    // Only the two slots before the end are contiguous, the rest follows from the start
+    HOST_CHECK(CIRCULAR_BUFFER_reserve(&hbuf, &span) == 2);
+    HOST_CHECK(span == &storage[1 + 8]);
+    HOST_CHECK(CIRCULAR_BUFFER_commit(&hbuf, 3) == STMLIBS_ERROR);
+    ((uint32_t *)span)[0] = 100;
+    ((uint32_t *)span)[1] = 101;
+    HOST_CHECK(CIRCULAR_BUFFER_commit(&hbuf, 2) == STMLIBS_OK);
+
+    HOST_CHECK(CIRCULAR_BUFFER_reserve(&hbuf, &span) == LENGTH - 3);
+    HOST_CHECK(span == &storage[1]);
+    ((uint32_t *)span)[0] = 102;
+    HOST_CHECK(CIRCULAR_BUFFER_commit(&hbuf, 1) == STMLIBS_OK);
+    HOST_CHECK(CIRCULAR_BUFFER_count(&hbuf) == 3);
+
+    // The readable span stops at the end too
+    HOST_CHECK(CIRCULAR_BUFFER_peek(&hbuf, &span) == 2);
+    HOST_CHECK(span == &storage[1 + 8] && ((uint32_t *)span)[1] == 101);
+    HOST_CHECK(CIRCULAR_BUFFER_release(&hbuf, 3) == STMLIBS_ERROR);
+    HOST_CHECK(CIRCULAR_BUFFER_release(&hbuf, 2) == STMLIBS_OK);
+    HOST_CHECK(CIRCULAR_BUFFER_peek(&hbuf, &span) == 1);
+    HOST_CHECK(span == &storage[1] && ((uint32_t *)span)[0] == 102);
+    HOST_CHECK(CIRCULAR_BUFFER_release(&hbuf, 1) == STMLIBS_OK);
+
+    HOST_CHECK(CIRCULAR_BUFFER_is_empty(&hbuf));
+    HOST_CHECK(CIRCULAR_BUFFER_peek(&hbuf, &span) == 0);
+    HOST_CHECK(CIRCULAR_BUFFER_release(&hbuf, 1) == STMLIBS_ERROR);
+}
+
+static void random_spans(void) {
+    uint32_t written = 0, read = 0;
+    uint32_t seed    = 42;
+
+    HOST_CHECK(CIRCULAR_BUFFER_init(&hbuf, &storage[1], LENGTH, sizeof(uint32_t)) == STMLIBS_OK);
+
+    for (uint32_t step = 0; step < 1000000; ++step) {
+        void *span;
+        seed = seed * 1103515245U + 12345U;
+
+        if ((seed >> 16) & 1) {
+            uint32_t n = CIRCULAR_BUFFER_reserve(&hbuf, &span);
+            check_span(span, n);
+            HOST_CHECK(n <= CIRCULAR_BUFFER_free_space(&hbuf));
+            HOST_CHECK(n > 0 || CIRCULAR_BUFFER_is_full(&hbuf));
+
+            uint32_t used = n == 0 ? 0 : (seed >> 20) % (n + 1);
+            for (uint32_t i = 0; i < used; ++i) {
+                ((uint32_t *)span)[i] = written + i;
+            }
+            HOST_CHECK(CIRCULAR_BUFFER_commit(&hbuf, n + 1) == STMLIBS_ERROR);
+            HOST_CHECK(CIRCULAR_BUFFER_commit(&hbuf, used) == STMLIBS_OK);
+            written += used;
+        } else {
+            uint32_t n = CIRCULAR_BUFFER_peek(&hbuf, &span);
+            check_span(span, n);
+            HOST_CHECK(n <= CIRCULAR_BUFFER_count(&hbuf));
+            HOST_CHECK(n > 0 || CIRCULAR_BUFFER_is_empty(&hbuf));
+
+            uint32_t used = n == 0 ? 0 : (seed >> 20) % (n + 1);
+            for (uint32_t i = 0; i < used; ++i) {
+                HOST_CHECK(((uint32_t *)span)[i] == read + i);
+            }
+            HOST_CHECK(CIRCULAR_BUFFER_release(&hbuf, n + 1) == STMLIBS_ERROR);
+            HOST_CHECK(CIRCULAR_BUFFER_release(&hbuf, used) == STMLIBS_OK);
+            read += used;
+        }
+
+        HOST_CHECK(CIRCULAR_BUFFER_count(&hbuf) == written - read);
+    }
+
+    // Every element went through the wrap point many times
+    HOST_CHECK(read > 100 * LENGTH);
+}
+
+int main(void) {
+    storage[0]          = GUARD;
+    storage[1 + LENGTH] = GUARD;
+
+    wrap();
+    random_spans();
+
+    HOST_CHECK(storage[0] == GUARD && storage[1 + LENGTH] == GUARD);
+
+    printf("span_test: ok\n");
+
+    return 0;
+}
@@ -0,0 +1,132 @@
+/*
+ * "THE BEER-WARE LICENSE" (Revision 69):
+ * Squadra Corse firmware team wrote this file. As long as you retain this notice
+ * you can do whatever you want with this stuff. If we meet some day, and you
+ * think this stuff is worth it, you can buy us a beer in return.
+ *
+ * Authors
+ * - Federico Carbone [federico.carbone.sc@gmail.com]
+ */
+
+/*
+ * Two threads, one producer and one consumer, share a small SPSC buffer for
+ * millions of elements. Every element carries its sequence number and a
+ * checksum of it, so a lost, duplicated, reordered or torn element fails the
+ * test. The consumer alternates dequeue and peek/release.
+ */
+
+#include "circular_buffer_spsc.h"
+#include "host.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <string.h>
+
+#define LENGTH   16
+#define ELEMENTS 2000000U
+
+struct Element {
+    uint32_t sequence;
+    uint32_t check;
+    uint8_t padding[24];
+};
+
+static struct Element storage[LENGTH];
+static CIRCULAR_BUFFER_SPSC_HandleTypeDef hbuf;
+
+static uint32_t check_of(uint32_t sequence) {
+    return sequence * 2654435761U ^ 0xA5A5A5A5U;
+}
+
+static void *producer(void *arg) {
+    (void)arg;
+
+    for (uint32_t i = 0; i < ELEMENTS;) {
+        struct Element element = {.sequence = i, .check = check_of(i)};
+        memset(element.padding, (uint8_t)i, sizeof(element.padding));
+
+        // Yield when full, the test must also progress on a single core
+        while (CIRCULAR_BUFFER_SPSC_enqueue(&hbuf, &element) != STMLIBS_OK) {
+            sched_yield();
+        }
+        ++i;
+    }
+
+    return NULL;
+}
+
+static void check_element(const struct Element *element, uint32_t expected) {
+    HOST_CHECK(element->sequence == expected);
+    HOST_CHECK(element->check == check_of(expected));
+    for (uint32_t i = 0; i < sizeof(element->padding); ++i) {
+        HOST_CHECK(element->padding[i] == (uint8_t)expected);
+    }
+}
+
+static void *consumer(void *arg) {
+    (void)arg;
+
+    uint32_t expected = 0;
+    while (expected < ELEMENTS) {
+        if (expected & 1) {
+            struct Element element;
+            if (CIRCULAR_BUFFER_SPSC_dequeue(&hbuf, &element) == STMLIBS_OK) {
+                check_element(&element, expected++);
+            } else {
+                sched_yield();
+            }
+        } else {
+            void *span;
+            uint32_t n = CIRCULAR_BUFFER_SPSC_peek(&hbuf, &span);
+            for (uint32_t i = 0; i < n; ++i) {
+                check_element((struct Element *)span + i, expected + i);
+            }
+            HOST_CHECK(CIRCULAR_BUFFER_SPSC_release(&hbuf, n) == STMLIBS_OK);
+            expected += n;
+            if (n == 0) {
+                sched_yield();
+            }
+        }
+    }
+
+    return NULL;
+}
+
+int main(void) {
+    HOST_CHECK(CIRCULAR_BUFFER_SPSC_init(&hbuf, storage, 12, sizeof(struct Element)) == STMLIBS_ERROR);
+    HOST_CHECK(CIRCULAR_BUFFER_SPSC_init(&hbuf, storage, LENGTH, sizeof(struct Element)) == STMLIBS_OK);
+
+    // Every function rejects a NULL handle
+    struct Element element;
+    void *span;
+    HOST_CHECK(CIRCULAR_BUFFER_SPSC_init(NULL, storage, LENGTH, sizeof(element)) == STMLIBS_ERROR);
+    HOST_CHECK(CIRCULAR_BUFFER_SPSC_enqueue(NULL, &element) == STMLIBS_ERROR);
+    HOST_CHECK(CIRCULAR_BUFFER_SPSC_dequeue(NULL, &element) == STMLIBS_ERROR);
+    HOST_CHECK(CIRCULAR_BUFFER_SPSC_peek(NULL, &span) == 0);
+    HOST_CHECK(CIRCULAR_BUFFER_SPSC_release(NULL, 0) == STMLIBS_ERROR);
+    HOST_CHECK(CIRCULAR_BUFFER_SPSC_count(NULL) == 0);
+    HOST_CHECK(CIRCULAR_BUFFER_SPSC_is_full(NULL) == 1);
+    HOST_CHECK(CIRCULAR_BUFFER_SPSC_is_empty(NULL) == 1);
+
+    // All the slots are usable
+    for (uint32_t i = 0; i < LENGTH; ++i) {
+        HOST_CHECK(CIRCULAR_BUFFER_SPSC_enqueue(&hbuf, &element) == STMLIBS_OK);
+    }
+    HOST_CHECK(CIRCULAR_BUFFER_SPSC_is_full(&hbuf));
+    HOST_CHECK(CIRCULAR_BUFFER_SPSC_enqueue(&hbuf, &element) == STMLIBS_ERROR);
+    HOST_CHECK(CIRCULAR_BUFFER_SPSC_release(&hbuf, LENGTH + 1) == STMLIBS_ERROR);
+    HOST_CHECK(CIRCULAR_BUFFER_SPSC_release(&hbuf, LENGTH) == STMLIBS_OK);
+    HOST_CHECK(CIRCULAR_BUFFER_SPSC_is_empty(&hbuf));
+
+    pthread_t threads[2];
+    uint64_t start = host_ns();
+    pthread_create(&threads[0], NULL, producer, NULL);
+    pthread_create(&threads[1], NULL, consumer, NULL);
+    pthread_join(threads[0], NULL);
+    pthread_join(threads[1], NULL);
+
+    HOST_CHECK(CIRCULAR_BUFFER_SPSC_is_empty(&hbuf));
+    printf("spsc_stress: %u elements through %u slots in %.2f s\n", ELEMENTS, LENGTH, (host_ns() - start) / 1e9);
+
+    return 0;
+}
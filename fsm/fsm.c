@@ -31,23 +31,290 @@ STMLIBS_StatusTypeDef FSM_init(FSM_HandleTypeDef *handle,
     handle->events_sync   = 0;
     handle->events_async  = 0;
 
+    handle->queue   = NULL;
+    handle->payload = 0;
+
+    handle->unhandled_policy = FSM_UNHANDLED_DROP;
+
     handle->run_callback        = run_callback;
     handle->transition_callback = transition_callback;
 
     handle->config = config;
 
+    handle->timer         = NULL;
+    handle->deadline      = 0;
+    handle->timer_armed   = 0;
+    handle->timer_expired = 0;
+
+#ifdef FSM_TRACE_LENGTH
+    handle->trace = NULL;
+#endif
+
+    return STMLIBS_OK;
+}
+
+STMLIBS_StatusTypeDef FSM_timer_init(FSM_TimerTypeDef *timer, uint32_t period_ms) {
+    if (timer == NULL) {
+        return STMLIBS_ERROR;
+    }
+
+    if (period_ms == 0) {
+        return STMLIBS_ERROR;
+    }
+
+    timer->period_ms      = period_ms;
+    timer->now            = 0;
+    timer->handles_length = 0;
+
+    return STMLIBS_OK;
+}
+
+STMLIBS_StatusTypeDef FSM_attach_timer(FSM_HandleTypeDef *handle, FSM_TimerTypeDef *timer) {
+    if (handle == NULL || timer == NULL) {
+        return STMLIBS_ERROR;
+    }
+
+    if (handle->timer != NULL || timer->handles_length == FSM_TIMER_MAX_HANDLES) {
+        return STMLIBS_ERROR;
+    }
+
+    timer->handles[timer->handles_length] = handle;
+    ++timer->handles_length;
+
+    handle->timer = timer;
+
     return STMLIBS_OK;
 }
 
+STMLIBS_StatusTypeDef FSM_timer_tick(FSM_TimerTypeDef *timer) {
+    if (timer == NULL) {
+        return STMLIBS_ERROR;
+    }
+
+    timer->now += timer->period_ms;
+
+    for (uint8_t i = 0; i < timer->handles_length; ++i) {
+        FSM_HandleTypeDef *handle = timer->handles[i];
+
+        // Signed difference, so the comparison survives the wrap around of now
+        if (handle->timer_armed && (int32_t)(timer->now - handle->deadline) >= 0) {
+            handle->timer_armed   = 0;
+            handle->timer_expired = 1;
+        }
+    }
+
+    return STMLIBS_OK;
+}
+
+/**
+ * @brief     Arm the deadline of the current state, dropping the one of the state left
+ */
+static inline void _FSM_timer_arm(FSM_HandleTypeDef *handle) {
+    handle->timer_armed   = 0;
+    handle->timer_expired = 0;
+
+    if (handle->timer == NULL || handle->config->timeouts == NULL) {
+        return;
+    }
+
+    uint32_t after_ms = handle->config->timeouts[handle->current_state].after_ms;
+    if (after_ms == 0) {
+        return;
+    }
+
+    // now lags the real time by up to one period, adding it the timeout never fires early
+    handle->deadline    = handle->timer->now + after_ms + handle->timer->period_ms;
+    handle->timer_armed = 1;
+}
+
+#ifdef FSM_TRACE_LENGTH
+STMLIBS_StatusTypeDef FSM_init_trace(FSM_HandleTypeDef *handle, FSM_TraceTypeDef *trace, FSM_StateStatsTypeDef *stats) {
+    if (handle == NULL) {
+        return STMLIBS_ERROR;
+    }
+
+    if (trace == NULL || stats == NULL) {
+        return STMLIBS_ERROR;
+    }
+
+    memset(trace, 0, sizeof(*trace));
+    memset(stats, 0, handle->config->state_length * sizeof(*stats));
+    for (uint8_t i = 0; i < handle->config->state_length; ++i) {
+        stats[i].do_work.min       = UINT32_MAX;
+        stats[i].event_handler.min = UINT32_MAX;
+    }
+
+    trace->entered = HAL_GetTick();
+    trace->stats   = stats;
+    handle->trace  = trace;
+
+    return STMLIBS_OK;
+}
+
+STMLIBS_StatusTypeDef FSM_get_trace(FSM_HandleTypeDef *handle, uint32_t age, FSM_TraceRecordTypeDef *record) {
+    if (handle == NULL || handle->trace == NULL || record == NULL) {
+        return STMLIBS_ERROR;
+    }
+
+    if (age >= handle->trace->head || age >= FSM_TRACE_LENGTH) {
+        return STMLIBS_ERROR;
+    }
+
+    *record = handle->trace->records[(handle->trace->head - 1 - age) & (FSM_TRACE_LENGTH - 1)];
+
+    return STMLIBS_OK;
+}
+
+uint32_t FSM_get_time_in_state(FSM_HandleTypeDef *handle, uint32_t state) {
+    if (handle == NULL || handle->trace == NULL || state >= handle->config->state_length) {
+        return 0;
+    }
+
+    uint32_t time = handle->trace->stats[state].time_in_state;
+    if (state == handle->current_state) {
+        time += HAL_GetTick() - handle->trace->entered;
+    }
+
+    return time;
+}
+
+/**
+ * @brief     Cycle counter at the start of a profiled call
+ */
+static inline uint32_t _FSM_trace_begin(FSM_HandleTypeDef *handle) {
+    return handle->trace != NULL ? FSM_TRACE_GET_CYCLES() : 0;
+}
+
+/**
+ * @brief     Account the cycles since start to the do_work or event_handler profile of state
+ */
+static inline void _FSM_trace_profile(FSM_HandleTypeDef *handle, uint32_t state, uint8_t do_work, uint32_t start) {
+    if (handle->trace == NULL) {
+        return;
+    }
+
+    uint32_t cycles              = FSM_TRACE_GET_CYCLES() - start;
+    FSM_StateStatsTypeDef *stats = &handle->trace->stats[state];
+    FSM_ProfileTypeDef *profile  = do_work ? &stats->do_work : &stats->event_handler;
+
+    if (cycles < profile->min) {
+        profile->min = cycles;
+    }
+    if (cycles > profile->max) {
+        profile->max = cycles;
+    }
+    ++profile->count;
+    profile->total += cycles;
+}
+
+/**
+ * @brief     Record a transition out of the current state, rejected ones included
+ */
+static inline void _FSM_trace_transition(FSM_HandleTypeDef *handle, uint32_t state, uint8_t event) {
+    if (handle->trace == NULL) {
+        return;
+    }
+
+    FSM_TraceTypeDef *trace        = handle->trace;
+    uint32_t now                   = HAL_GetTick();
+    FSM_TraceRecordTypeDef *record = &trace->records[trace->head++ & (FSM_TRACE_LENGTH - 1)];
+
+    record->timestamp = now;
+    record->from      = handle->current_state;
+    record->to        = state < UINT8_MAX ? state : UINT8_MAX;
+    record->event     = event;
+
+    if (state < handle->config->state_length) {
+        trace->stats[handle->current_state].time_in_state += now - trace->entered;
+        trace->entered = now;
+    }
+}
+#else
+#define _FSM_trace_begin(handle)                          0U
+#define _FSM_trace_profile(handle, state, do_work, start) ((void)(start))
+#define _FSM_trace_transition(handle, state, event)       ((void)(event))
+#endif  // FSM_TRACE_LENGTH
+
+/**
+ * @brief     Ancestors of state, outermost first and state itself last
+ *
+ * @param     flat Storage for the path of a flat machine, the state alone
+ * @return    path of depth states
+ */
+static inline const uint8_t *_FSM_path(FSM_ConfigTypeDef *config, uint32_t state, uint8_t *depth, uint8_t *flat) {
+    if (config->hierarchy == NULL) {
+        *flat  = state;
+        *depth = 1;
+        return flat;
+    }
+
+    *depth = config->hierarchy->depths[state];
+    return &config->hierarchy->paths[state * config->hierarchy->max_depth];
+}
+
+/**
+ * @brief     Whether the handler of state takes event, events past the masks are always taken
+ */
+static inline uint8_t _FSM_handles(FSM_ConfigTypeDef *config, uint32_t state, uint8_t event) {
+    if (config->state_table[state].event_handler == NULL) {
+        return 0;
+    }
+
+    return config->event_masks == NULL || event >= FSM_MAX_EVENTS || (config->event_masks[state] & (1U << event));
+}
+
+/**
+ * @brief     Deepest state on path whose handler takes event, the outermost one is the last resort
+ */
+static inline uint32_t _FSM_owner(FSM_ConfigTypeDef *config, const uint8_t *path, uint8_t depth, uint8_t event) {
+    uint8_t level = depth - 1;
+    while (level > 0 && !_FSM_handles(config, path[level], event)) {
+        --level;
+    }
+
+    return path[level];
+}
+
+/**
+ * @brief     Events handled by the states on path, the current state and its ancestors
+ *
+ * @param     handlers Set to the number of states on path with an event handler
+ */
+static inline uint32_t _FSM_handled(FSM_ConfigTypeDef *config, const uint8_t *path, uint8_t depth, uint8_t *handlers) {
+    uint32_t handled = 0;
+
+    *handlers = 0;
+    for (uint8_t i = 0; i < depth; ++i) {
+        if (config->state_table[path[i]].event_handler != NULL) {
+            handled |= config->event_masks != NULL ? config->event_masks[path[i]] : ~0U;
+            ++*handlers;
+        }
+    }
+
+    return handled;
+}
+
 STMLIBS_StatusTypeDef FSM_start(FSM_HandleTypeDef *handle) {
     if (handle == NULL) {
         return STMLIBS_ERROR;
     }
 
-    if (handle->config->state_length > 0 && handle->config->state_table[0].entry != NULL) {
-        handle->config->state_table[0].entry();
+    if (handle->config->state_length == 0) {
+        return STMLIBS_OK;
+    }
+
+    uint8_t depth, flat;
+    const uint8_t *path = _FSM_path(handle->config, 0, &depth, &flat);
+
+    // Parents are entered before their children
+    for (uint8_t i = 0; i < depth; ++i) {
+        if (handle->config->state_table[path[i]].entry != NULL) {
+            handle->config->state_table[path[i]].entry();
+        }
     }
 
+    _FSM_timer_arm(handle);
+
     return STMLIBS_OK;
 }
 
@@ -55,17 +322,51 @@ uint32_t FSM_get_state(FSM_HandleTypeDef *handle) {
     return handle->current_state;
 }
 
-STMLIBS_StatusTypeDef FSM_trigger_event(FSM_HandleTypeDef *handle, uint8_t event) {
-    uint32_t mask = 1 << event;
+uint8_t FSM_is_ready(FSM_HandleTypeDef *handle) {
+    if (handle == NULL) {
+        return 0;
+    }
+
+    FSM_ConfigTypeDef *config = handle->config;
 
+    if (handle->timer_expired || config->state_table[handle->current_state].do_work != NULL) {
+        return 1;
+    }
+
+    uint32_t pending = handle->events_async ^ handle->events_sync;
+    uint8_t queued   = handle->queue != NULL && !CIRCULAR_BUFFER_MPSC_is_empty(handle->queue);
+
+    if (pending == 0 && !queued) {
+        return 0;
+    }
+
+    // Same conditions FSM_routine handles, or drops, events with
+    uint8_t depth, flat, handlers;
+    const uint8_t *path = _FSM_path(config, handle->current_state, &depth, &flat);
+    uint32_t handled    = _FSM_handled(config, path, depth, &handlers);
+
+    if (handlers == 0) {
+        return 0;
+    }
+
+    if (handle->unhandled_policy == FSM_UNHANDLED_DROP) {
+        handled = ~0U;
+    }
+
+    return (pending & handled) != 0 || queued;
+}
+
+STMLIBS_StatusTypeDef FSM_trigger_event(FSM_HandleTypeDef *handle, uint8_t event) {
     if (handle == NULL) {
         return STMLIBS_ERROR;
     }
 
-    if (event >= handle->events_length) {
+    // Only the queue carries events past the bitmask width
+    if (event >= handle->events_length || event >= FSM_MAX_EVENTS) {
         return STMLIBS_ERROR;
     }
 
+    uint32_t mask = 1U << event;
     if (~(handle->events_async ^ handle->events_sync) & mask) {
         handle->events_async ^= mask;
     }
@@ -73,25 +374,87 @@ STMLIBS_StatusTypeDef FSM_trigger_event(FSM_HandleTypeDef *handle, uint8_t event
     return STMLIBS_OK;
 }
 
-STMLIBS_StatusTypeDef _FSM_transition(FSM_HandleTypeDef *handle, uint32_t state) {
+STMLIBS_StatusTypeDef FSM_set_unhandled_policy(FSM_HandleTypeDef *handle, FSM_UnhandledPolicyTypeDef policy) {
+    if (handle == NULL) {
+        return STMLIBS_ERROR;
+    }
+
+    handle->unhandled_policy = policy;
+
+    return STMLIBS_OK;
+}
+
+STMLIBS_StatusTypeDef FSM_init_queue(FSM_HandleTypeDef *handle, CIRCULAR_BUFFER_MPSC_HandleTypeDef *queue) {
+    if (handle == NULL) {
+        return STMLIBS_ERROR;
+    }
+
+    // mask is 0 on a queue never initialized, CIRCULAR_BUFFER_MPSC_init rejects a single slot
+    if (queue == NULL || queue->size != sizeof(FSM_EventTypeDef) || queue->mask == 0) {
+        return STMLIBS_ERROR;
+    }
+
+    handle->queue = queue;
+
+    return STMLIBS_OK;
+}
+
+STMLIBS_StatusTypeDef FSM_post_event(FSM_HandleTypeDef *handle, uint8_t event, uint32_t payload) {
+    FSM_EventTypeDef element = {.event = event, .payload = payload};
+
+    if (handle == NULL || handle->queue == NULL) {
+        return STMLIBS_ERROR;
+    }
+
+    if (event >= handle->events_length) {
+        return STMLIBS_ERROR;
+    }
+
+    return CIRCULAR_BUFFER_MPSC_enqueue(handle->queue, &element);
+}
+
+uint32_t FSM_get_payload(FSM_HandleTypeDef *handle) {
+    return handle->payload;
+}
+
+STMLIBS_StatusTypeDef _FSM_transition(FSM_HandleTypeDef *handle, uint32_t state, uint8_t event) {
     if (handle == NULL) {
         return STMLIBS_ERROR;
     }
 
+    _FSM_trace_transition(handle, state, event);
+
     if (state >= handle->config->state_length) {
         return STMLIBS_ERROR;
     }
 
-    if (handle->config->state_table[handle->current_state].exit != NULL) {
-        handle->config->state_table[handle->current_state].exit();
+    FSM_ConfigTypeDef *config = handle->config;
+    uint8_t from_depth, to_depth, from_flat, to_flat;
+    const uint8_t *from = _FSM_path(config, handle->current_state, &from_depth, &from_flat);
+    const uint8_t *to   = _FSM_path(config, state, &to_depth, &to_flat);
+
+    // The common ancestors are neither exited nor entered
+    uint8_t common = 0;
+    if (config->hierarchy != NULL) {
+        common = config->hierarchy->lca_depths[handle->current_state * config->state_length + state];
+    }
+
+    for (uint8_t i = from_depth; i > common; --i) {
+        if (config->state_table[from[i - 1]].exit != NULL) {
+            config->state_table[from[i - 1]].exit();
+        }
     }
 
     handle->current_state = state;
 
-    if (handle->config->state_table[handle->current_state].entry != NULL) {
-        handle->config->state_table[handle->current_state].entry();
+    for (uint8_t i = common; i < to_depth; ++i) {
+        if (config->state_table[to[i]].entry != NULL) {
+            config->state_table[to[i]].entry();
+        }
     }
 
+    _FSM_timer_arm(handle);
+
     if(handle->transition_callback != NULL) {
         handle->transition_callback(state);
     }
@@ -104,25 +467,86 @@ STMLIBS_StatusTypeDef FSM_routine(FSM_HandleTypeDef *handle) {
         return STMLIBS_ERROR;
     }
 
-    if (handle->config->state_table[handle->current_state].event_handler != NULL) {
-        for (uint8_t i = 0; i < handle->events_length; ++i) {
-            uint32_t mask = 1 << i;
-            if ((handle->events_async ^ handle->events_sync) & mask) {
-                handle->events_async ^= mask;
-                uint32_t ret = handle->config->state_table[handle->current_state].event_handler(i);
+    FSM_ConfigTypeDef *config = handle->config;
+    FSM_StateTypeDef *state   = &config->state_table[handle->current_state];
+
+    uint8_t depth, flat;
+    const uint8_t *path = _FSM_path(config, handle->current_state, &depth, &flat);
+
+    uint8_t handlers;
+    uint32_t handled = _FSM_handled(config, path, depth, &handlers);
+
+    if (handlers != 0) {
+        // events_async is toggled by FSM_trigger_event, events_sync only here
+        uint32_t pending = handle->events_async ^ handle->events_sync;
+
+        // Unhandled events never reach the handler
+        if (handle->unhandled_policy == FSM_UNHANDLED_DROP) {
+            handle->events_sync ^= pending & ~handled;
+        }
+        pending &= handled;
+
+        // Only the pending bits are visited, lowest event first
+        while (pending != 0) {
+            uint8_t event = __builtin_ctz(pending);
+            pending &= pending - 1;
+
+            // Consumed one at a time, so an event triggered again meanwhile is never lost
+            handle->events_sync ^= 1U << event;
+            handle->payload = 0;
+
+            // Events bubble up from the current state to its ancestors
+            uint32_t owner = depth > 1 ? _FSM_owner(config, path, depth, event) : handle->current_state;
+            uint32_t start = _FSM_trace_begin(handle);
+            uint32_t ret   = config->state_table[owner].event_handler(event);
+            _FSM_trace_profile(handle, owner, 0, start);
+
+            if (ret != owner && ret != handle->current_state) {
+                return _FSM_transition(handle, ret, event);
+            }
+        }
+    }
+
+    if (handle->queue != NULL && handlers != 0) {
+        FSM_EventTypeDef element;
+
+        // Bounded to one queue length, so producers posting continuously cannot starve do_work
+        for (uint32_t i = 0; i <= handle->queue->mask; ++i) {
+            if (CIRCULAR_BUFFER_MPSC_dequeue(handle->queue, &element) != STMLIBS_OK) {
+                break;
+            }
+
+            // The mask covers the events below FSM_MAX_EVENTS only
+            if (element.event < FSM_MAX_EVENTS && !(handled & (1U << element.event))) {
+                continue;
+            }
 
-                if (ret != handle->current_state) {
-                    return _FSM_transition(handle, ret);
-                }
+            uint32_t owner  = depth > 1 ? _FSM_owner(config, path, depth, element.event) : handle->current_state;
+            handle->payload = element.payload;
+            uint32_t start  = _FSM_trace_begin(handle);
+            uint32_t ret    = config->state_table[owner].event_handler(element.event);
+            _FSM_trace_profile(handle, owner, 0, start);
+
+            // The events left in the queue are handled by the next state
+            if (ret != owner && ret != handle->current_state) {
+                return _FSM_transition(handle, ret, element.event);
             }
         }
     }
 
-    if (handle->config->state_table[handle->current_state].do_work != NULL) {
-        uint32_t ret = handle->config->state_table[handle->current_state].do_work();
+    // Set by FSM_timer_tick, cleared whenever a state is entered
+    if (handle->timer_expired) {
+        handle->timer_expired = 0;
+        return _FSM_transition(handle, config->timeouts[handle->current_state].target, FSM_TRACE_TIMEOUT);
+    }
+
+    if (state->do_work != NULL) {
+        uint32_t start = _FSM_trace_begin(handle);
+        uint32_t ret   = state->do_work();
+        _FSM_trace_profile(handle, handle->current_state, 1, start);
 
         if (ret != handle->current_state) {
-            return _FSM_transition(handle, ret);
+            return _FSM_transition(handle, ret, FSM_TRACE_DO_WORK);
         }
     }
 
@@ -11,6 +11,7 @@
 #ifndef FSM_H
 #define FSM_H
 
+#include "circular_buffer_mpsc.h"
 #include "main.h"
 #include "stmlibs_status.h"
 
@@ -18,6 +19,31 @@
 
 #define FSM_MAX_EVENTS 32
 
+/*
+ * Define FSM_TRACE_LENGTH, a power of two, to record the last transitions and
+ * profile the state functions of the handles passed to FSM_init_trace. Left
+ * undefined, the instrumentation is compiled out and the handle is unchanged.
+ */
+#ifdef FSM_TRACE_LENGTH
+#if FSM_TRACE_LENGTH == 0 || (FSM_TRACE_LENGTH & (FSM_TRACE_LENGTH - 1)) != 0
+#error "FSM_TRACE_LENGTH must be a power of two"
+#endif
+
+/** @brief Cycle counter used by the profiling, DWT->CYCCNT must be enabled by the application */
+#ifndef FSM_TRACE_GET_CYCLES
+#define FSM_TRACE_GET_CYCLES() (DWT->CYCCNT)
+#endif
+#endif  // FSM_TRACE_LENGTH
+
+/** @brief Event of a transition returned by do_work in the trace records */
+#define FSM_TRACE_DO_WORK 0xFF
+/** @brief Event of a transition taken on a state timeout in the trace records */
+#define FSM_TRACE_TIMEOUT 0xFE
+
+#ifndef FSM_TIMER_MAX_HANDLES
+#define FSM_TIMER_MAX_HANDLES 8
+#endif  // FSM_TIMER_MAX_HANDLES
+
 typedef void (*FSM_void_function)(void);
 typedef void (*FSM_callback_function)(uint32_t state);
 typedef uint32_t (*FSM_state_function)(void);
@@ -31,12 +57,101 @@ struct FSM_StateStruct {
 };
 typedef struct FSM_StateStruct FSM_StateTypeDef;
 
+/**
+ * @brief Nesting of the states, generated by fsmgen from the DOT clusters.
+ *        Entry and exit chains are read from the tables, never searched.
+ */
+struct FSM_HierarchyStruct {
+    uint8_t max_depth;
+    /** @brief Number of states from the outermost ancestor to the state itself, included */
+    const uint8_t *depths;
+    /** @brief state_length rows of max_depth states, outermost ancestor first and the state itself last */
+    const uint8_t *paths;
+    /** @brief state_length x state_length matrix, number of ancestors two states have in common */
+    const uint8_t *lca_depths;
+};
+typedef struct FSM_HierarchyStruct FSM_HierarchyTypeDef;
+
+/** @brief Transition taken by the engine when a state lasts after_ms, generated by fsmgen from the after edges */
+struct FSM_TimeoutStruct {
+    /** @brief 0 if the state has no timeout */
+    uint32_t after_ms;
+    uint32_t target;
+};
+typedef struct FSM_TimeoutStruct FSM_TimeoutTypeDef;
+
 struct FSM_ConfigStruct {
     uint8_t state_length;
     FSM_StateTypeDef *state_table;
+    /** @brief Per state bitmask of the events passed to the event handler, NULL for all of them */
+    const uint32_t *event_masks;
+    /**
+     * @brief Parent states, NULL for a flat machine. Events a state does not
+     *        handle bubble up to its ancestors; a handler returning its own
+     *        state, or the current one, does not transition.
+     */
+    const FSM_HierarchyTypeDef *hierarchy;
+    /** @brief Per state timeout, NULL if no state has one */
+    const FSM_TimeoutTypeDef *timeouts;
 };
 typedef struct FSM_ConfigStruct FSM_ConfigTypeDef;
 
+typedef enum {
+    /** @brief Events outside the state mask are consumed without calling the handler */
+    FSM_UNHANDLED_DROP,
+    /** @brief Events outside the state mask stay pending until a state handling them is entered */
+    FSM_UNHANDLED_KEEP
+} FSM_UnhandledPolicyTypeDef;
+
+/** @brief Element of the queue passed to FSM_init_queue */
+struct FSM_EventStruct {
+    uint8_t event;
+    uint32_t payload;
+};
+typedef struct FSM_EventStruct FSM_EventTypeDef;
+
+#ifdef FSM_TRACE_LENGTH
+struct FSM_TraceRecordStruct {
+    /** @brief HAL_GetTick() at the transition */
+    uint32_t timestamp;
+    uint8_t from;
+    uint8_t to;
+    /** @brief Event whose handler returned to, FSM_TRACE_DO_WORK if it was do_work */
+    uint8_t event;
+};
+typedef struct FSM_TraceRecordStruct FSM_TraceRecordTypeDef;
+
+/** @brief Cycles spent in a state function per call, the mean is total / count */
+struct FSM_ProfileStruct {
+    uint32_t count;
+    uint32_t min;
+    uint32_t max;
+    uint64_t total;
+};
+typedef struct FSM_ProfileStruct FSM_ProfileTypeDef;
+
+struct FSM_StateStatsStruct {
+    /** @brief Milliseconds spent in the state, the current visit is added when it is left */
+    uint32_t time_in_state;
+    FSM_ProfileTypeDef do_work;
+    FSM_ProfileTypeDef event_handler;
+};
+typedef struct FSM_StateStatsStruct FSM_StateStatsTypeDef;
+
+struct FSM_TraceStruct {
+    FSM_TraceRecordTypeDef records[FSM_TRACE_LENGTH];
+    /** @brief Free running number of transitions recorded */
+    uint32_t head;
+    /** @brief HAL_GetTick() at the entry of the current state */
+    uint32_t entered;
+    /** @brief One element per state */
+    FSM_StateStatsTypeDef *stats;
+};
+typedef struct FSM_TraceStruct FSM_TraceTypeDef;
+#endif  // FSM_TRACE_LENGTH
+
+struct FSM_TimerStruct;
+
 struct FSM_HandleStruct {
     uint32_t current_state;
 
@@ -44,13 +159,41 @@ struct FSM_HandleStruct {
     uint32_t events_sync;
     uint32_t events_async;
 
+    CIRCULAR_BUFFER_MPSC_HandleTypeDef *queue;
+    uint32_t payload;
+
+    uint8_t unhandled_policy;
+
     FSM_callback_function run_callback;
     FSM_callback_function transition_callback;
 
     FSM_ConfigTypeDef *config;
+
+    /** @brief Service checking the deadline, armed on entry of a state with a timeout */
+    struct FSM_TimerStruct *timer;
+    uint32_t deadline;
+    uint8_t timer_armed;
+    uint8_t timer_expired;
+
+#ifdef FSM_TRACE_LENGTH
+    FSM_TraceTypeDef *trace;
+#endif
 };
 typedef struct FSM_HandleStruct FSM_HandleTypeDef;
 
+/**
+ * @brief Deadlines of the state timeouts of several handles, advanced by a
+ *        periodic callback so that no state polls the time in do_work
+ */
+struct FSM_TimerStruct {
+    uint32_t period_ms;
+    /** @brief Free running time in ms, advanced by period_ms on every tick */
+    uint32_t now;
+    FSM_HandleTypeDef *handles[FSM_TIMER_MAX_HANDLES];
+    uint8_t handles_length;
+};
+typedef struct FSM_TimerStruct FSM_TimerTypeDef;
+
 /**
  * @brief     Initialize a FSM_HandleTypeDef structure 
  * 
@@ -80,6 +223,15 @@ STMLIBS_StatusTypeDef FSM_start(FSM_HandleTypeDef *handle);
  * @return    state of the fsm
  */
 uint32_t FSM_get_state(FSM_HandleTypeDef *handle);
+/**
+ * @brief     Whether FSM_routine has something to do: pending events the
+ *                current state handles or drops, queued events, an expired
+ *                timeout or a do_work to poll
+ *
+ * @param     handle Reference to the initialized struct
+ * @return    1 if ready, 0 if FSM_routine would only run the run_callback
+ */
+uint8_t FSM_is_ready(FSM_HandleTypeDef *handle);
 /**
  * @brief     Trigger an event on the FSM_HandleTypeDef structure 
  * 
@@ -88,6 +240,103 @@ uint32_t FSM_get_state(FSM_HandleTypeDef *handle);
  * @return    STMLIBS_OK on success, STMLIBS_ERROR on failure
  */
 STMLIBS_StatusTypeDef FSM_trigger_event(FSM_HandleTypeDef *handle, uint8_t event);
+/**
+ * @brief     Choose what happens to triggered events the current state does
+ *                not handle according to config->event_masks. Queued events
+ *                outside the mask are always dropped, keeping them would block
+ *                the queue.
+ *
+ * @param     handle Reference to the initialized struct
+ * @param     policy FSM_UNHANDLED_DROP (default) or FSM_UNHANDLED_KEEP
+ * @return    STMLIBS_OK on success, STMLIBS_ERROR on failure
+ */
+STMLIBS_StatusTypeDef FSM_set_unhandled_policy(FSM_HandleTypeDef *handle, FSM_UnhandledPolicyTypeDef policy);
+/**
+ * @brief     Enable the event queue on an initialized FSM_HandleTypeDef structure.
+ *                Unlike FSM_trigger_event, which merges repeated events into a
+ *                single bit, queued events are handled in arrival order, once
+ *                per post, each with its payload.
+ *
+ * @param     handle Reference to the initialized struct
+ * @param     queue Queue initialized with elements of sizeof(FSM_EventTypeDef), at least 2
+ * @return    STMLIBS_OK on success, STMLIBS_ERROR on failure
+ */
+STMLIBS_StatusTypeDef FSM_init_queue(FSM_HandleTypeDef *handle, CIRCULAR_BUFFER_MPSC_HandleTypeDef *queue);
+/**
+ * @brief     Queue an event, safe from any interrupt priority without critical sections
+ *
+ * @param     handle Reference to the initialized struct
+ * @param     event The event to be queued
+ * @param     payload Value returned by FSM_get_payload while the event is handled
+ * @return    STMLIBS_OK on success, STMLIBS_ERROR if the queue is full or missing
+ */
+STMLIBS_StatusTypeDef FSM_post_event(FSM_HandleTypeDef *handle, uint8_t event, uint32_t payload);
+/**
+ * @brief     Payload of the queued event being handled, valid only inside the
+ *                event handler. 0 for events from FSM_trigger_event.
+ *
+ * @param     handle Reference to the initialized struct
+ * @return    payload of the current event
+ */
+uint32_t FSM_get_payload(FSM_HandleTypeDef *handle);
+/**
+ * @brief     Initialize a FSM_TimerTypeDef structure. FSM_timer_tick must be
+ *                called every period_ms, e.g. from a TIMEBASE callback:
+ *                timeouts fire at most one period late and never early.
+ *
+ * @param     timer Reference to the struct to be initialized
+ * @param     period_ms Period of the FSM_timer_tick calls
+ * @return    STMLIBS_OK on success, STMLIBS_ERROR on failure
+ */
+STMLIBS_StatusTypeDef FSM_timer_init(FSM_TimerTypeDef *timer, uint32_t period_ms);
+/**
+ * @brief     Service the state timeouts of an initialized FSM_HandleTypeDef
+ *                structure with timer. To be attached before FSM_start, from
+ *                the context calling FSM_timer_tick and FSM_routine.
+ *
+ * @param     handle Reference to the initialized struct
+ * @param     timer Reference to the initialized timer
+ * @return    STMLIBS_OK on success, STMLIBS_ERROR on failure
+ */
+STMLIBS_StatusTypeDef FSM_attach_timer(FSM_HandleTypeDef *handle, FSM_TimerTypeDef *timer);
+/**
+ * @brief     Advance the time by one period and flag the expired deadlines,
+ *                the timeout transitions are taken by the next FSM_routine
+ *
+ * @param     timer Reference to the initialized timer
+ * @return    STMLIBS_OK on success, STMLIBS_ERROR on failure
+ */
+STMLIBS_StatusTypeDef FSM_timer_tick(FSM_TimerTypeDef *timer);
+#ifdef FSM_TRACE_LENGTH
+/**
+ * @brief     Start recording the transitions and profiling the state functions
+ *                of an initialized FSM_HandleTypeDef structure, clears trace
+ *                and stats. Only the context calling FSM_routine writes them.
+ *
+ * @param     handle Reference to the initialized struct
+ * @param     trace Storage of the transition ring
+ * @param     stats Storage of config->state_length elements
+ * @return    STMLIBS_OK on success, STMLIBS_ERROR on failure
+ */
+STMLIBS_StatusTypeDef FSM_init_trace(FSM_HandleTypeDef *handle, FSM_TraceTypeDef *trace, FSM_StateStatsTypeDef *stats);
+/**
+ * @brief     Get a recorded transition
+ *
+ * @param     handle Reference to the initialized struct
+ * @param     age 0 for the last transition, 1 for the one before and so on
+ * @param     record Destination of the transition
+ * @return    STMLIBS_OK on success, STMLIBS_ERROR if the transition was not recorded or was overwritten
+ */
+STMLIBS_StatusTypeDef FSM_get_trace(FSM_HandleTypeDef *handle, uint32_t age, FSM_TraceRecordTypeDef *record);
+/**
+ * @brief     Milliseconds spent in a state, the current visit included
+ *
+ * @param     handle Reference to the initialized struct
+ * @param     state The state
+ * @return    time in state, 0 if tracing is not enabled
+ */
+uint32_t FSM_get_time_in_state(FSM_HandleTypeDef *handle, uint32_t state);
+#endif  // FSM_TRACE_LENGTH
 /**
  * @brief     Routine to be called in the main loop
  * 
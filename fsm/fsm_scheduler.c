@@ -0,0 +1,98 @@
+/*
+ * "THE BEER-WARE LICENSE" (Revision 69):
+ * Squadra Corse firmware team wrote this file. As long as you retain this notice
+ * you can do whatever you want with this stuff. If we meet some day, and you
+ * think this stuff is worth it, you can buy us a beer in return.
+ *
+ * Authors
+ * - Federico Carbone [federico.carbone.sc@gmail.com]
+ */
+
+#include "fsm_scheduler.h"
+
+#include "critical_section.h"
+
+#ifndef __weak
+#define __weak __attribute__((weak))
+#endif  // __weak
+
+STMLIBS_StatusTypeDef FSM_SCHEDULER_init(FSM_SCHEDULER_HandleTypeDef *handle) {
+    if (handle == NULL) {
+        return STMLIBS_ERROR;
+    }
+
+    handle->fsms_length = 0;
+
+    return STMLIBS_OK;
+}
+
+STMLIBS_StatusTypeDef FSM_SCHEDULER_add(FSM_SCHEDULER_HandleTypeDef *handle, FSM_HandleTypeDef *fsm, uint8_t priority) {
+    if (handle == NULL || fsm == NULL) {
+        return STMLIBS_ERROR;
+    }
+
+    if (handle->fsms_length == FSM_SCHEDULER_MAX_FSMS) {
+        return STMLIBS_ERROR;
+    }
+
+    // Insertion keeps the order by priority, dispatch only scans
+    uint8_t i = handle->fsms_length;
+    for (; i > 0 && handle->priorities[i - 1] < priority; --i) {
+        handle->fsms[i]       = handle->fsms[i - 1];
+        handle->priorities[i] = handle->priorities[i - 1];
+    }
+
+    handle->fsms[i]       = fsm;
+    handle->priorities[i] = priority;
+    ++handle->fsms_length;
+
+    return STMLIBS_OK;
+}
+
+uint8_t FSM_SCHEDULER_dispatch(FSM_SCHEDULER_HandleTypeDef *handle) {
+    if (handle == NULL) {
+        return 0;
+    }
+
+    uint8_t runs = 0;
+
+    // One pass from the highest priority, a machine made ready by a later one waits for the next pass
+    for (uint8_t i = 0; i < handle->fsms_length; ++i) {
+        if (FSM_is_ready(handle->fsms[i])) {
+            FSM_routine(handle->fsms[i]);
+            ++runs;
+        }
+    }
+
+    return runs;
+}
+
+STMLIBS_StatusTypeDef FSM_SCHEDULER_routine(FSM_SCHEDULER_HandleTypeDef *handle) {
+    if (handle == NULL) {
+        return STMLIBS_ERROR;
+    }
+
+    if (FSM_SCHEDULER_dispatch(handle) != 0) {
+        return STMLIBS_OK;
+    }
+
+    // Checked again with the interrupts disabled, an event triggered after the check wakes up the sleep
+    CS_ENTER();
+
+    uint8_t ready = 0;
+    for (uint8_t i = 0; i < handle->fsms_length && !ready; ++i) {
+        ready = FSM_is_ready(handle->fsms[i]);
+    }
+
+    if (!ready) {
+        FSM_SCHEDULER_idle();
+    }
+
+    CS_EXIT();
+
+    return STMLIBS_OK;
+}
+
+__weak void FSM_SCHEDULER_idle(void) {
+    __WFI();
+}
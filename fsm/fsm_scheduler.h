@@ -0,0 +1,86 @@
+/*
+ * "THE BEER-WARE LICENSE" (Revision 69):
+ * Squadra Corse firmware team wrote this file. As long as you retain this notice
+ * you can do whatever you want with this stuff. If we meet some day, and you
+ * think this stuff is worth it, you can buy us a beer in return.
+ *
+ * Authors
+ * - Federico Carbone [federico.carbone.sc@gmail.com]
+ */
+
+/*
+ * Scheduler of several FSM_HandleTypeDef, replacing a main loop calling
+ * FSM_routine on each of them.
+ *
+ * Only the ready machines (see FSM_is_ready) are run, one FSM_routine at a
+ * time and highest priority first. A pass visits every machine once, so it
+ * costs O(N) and polling states cannot starve the lower priorities, whatever
+ * their priorities. A higher priority machine made ready during the pass, by
+ * a lower one or by an interrupt, runs first in the next pass. When nothing
+ * is ready FSM_SCHEDULER_idle is called with the interrupts disabled, the
+ * default one sleeps with __WFI.
+ */
+
+#ifndef FSM_SCHEDULER_H
+#define FSM_SCHEDULER_H
+
+#include "fsm.h"
+#include "main.h"
+#include "stmlibs_status.h"
+
+#include <inttypes.h>
+
+#define FSM_SCHEDULER_MAX_FSMS 32
+
+struct FSM_SCHEDULER_HandleStruct {
+    /** @brief Sorted by decreasing priority, the first added first among equal ones */
+    FSM_HandleTypeDef *fsms[FSM_SCHEDULER_MAX_FSMS];
+    uint8_t priorities[FSM_SCHEDULER_MAX_FSMS];
+    uint8_t fsms_length;
+};
+typedef struct FSM_SCHEDULER_HandleStruct FSM_SCHEDULER_HandleTypeDef;
+
+/**
+ * @brief     Initialize a FSM_SCHEDULER_HandleTypeDef structure
+ *
+ * @param     handle Reference to the struct to be initialized
+ * @return    STMLIBS_OK on success, STMLIBS_ERROR on failure
+ */
+STMLIBS_StatusTypeDef FSM_SCHEDULER_init(FSM_SCHEDULER_HandleTypeDef *handle);
+/**
+ * @brief     Add a started FSM_HandleTypeDef structure to the scheduler
+ *
+ * @param     handle Reference to the handle
+ * @param     fsm Machine to be scheduled
+ * @param     priority Higher values run first
+ * @return    STMLIBS_OK on success, STMLIBS_ERROR on failure
+ */
+STMLIBS_StatusTypeDef FSM_SCHEDULER_add(FSM_SCHEDULER_HandleTypeDef *handle, FSM_HandleTypeDef *fsm, uint8_t priority);
+/**
+ * @brief     Run every ready machine once, in priority order
+ *
+ * @param     handle Reference to the handle
+ * @return    number of FSM_routine calls, 0 if everything was idle
+ */
+uint8_t FSM_SCHEDULER_dispatch(FSM_SCHEDULER_HandleTypeDef *handle);
+/**
+ * @brief     Routine to be called in the main loop: runs the ready machines or,
+ *                if none is, sleeps in FSM_SCHEDULER_idle until an interrupt
+ *
+ * @param     handle Reference to the handle
+ * @return    STMLIBS_OK on success, STMLIBS_ERROR on failure
+ */
+STMLIBS_StatusTypeDef FSM_SCHEDULER_routine(FSM_SCHEDULER_HandleTypeDef *handle);
+/**
+ * @brief     Called with the interrupts disabled when no machine is ready, must
+ *                return when an interrupt is pending. The default executes
+ *                __WFI, which wakes up on a pending interrupt even when masked;
+ *                the interrupt is served once FSM_SCHEDULER_routine enables them
+ *                again. Where __WFI does not sleep, override it with a
+ *                blocking wait on whatever triggers the events.
+ *
+ * @attention this function is declared as weak.
+ */
+void FSM_SCHEDULER_idle(void);
+
+#endif  //FSM_SCHEDULER_H
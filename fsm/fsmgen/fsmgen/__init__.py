@@ -6,6 +6,7 @@
 # Authors
 # - Filippo Rossi <filippo.rossi.sc@gmail.com>
 
+import re
 from glob import glob
 from io import TextIOWrapper
 from pathlib import Path
@@ -13,37 +14,226 @@ from pathlib import Path
 import click
 import jinja2 as j2
 import networkx as nx
+import pydot
 
 dir = Path(__file__).parent
 source = j2.Template((dir / "fsm.c.j2").read_text())
 header = j2.Template((dir / "fsm.h.j2").read_text())
+standalone_source = j2.Template((dir / "fsm_standalone.c.j2").read_text())
+standalone_header = j2.Template((dir / "fsm_standalone.h.j2").read_text())
+harness_source = j2.Template((dir / "harness.c.j2").read_text())
+harness_header = j2.Template((dir / "harness_main.h.j2").read_text())
+
+
+def load(P: pydot.Dot) -> tuple:
+    """
+    Graph of the states and parent of every state, None at the top level.
+    A subgraph named cluster_X makes X the parent of the states mentioned in it.
+    """
+    G = nx.MultiDiGraph()
+    parents = {}
+    levels = {}
+
+    def member(state: str, parent, level: int):
+        G.add_node(state)
+        # Clusters are visited after their enclosing graph, so the innermost one wins
+        if level > levels.get(state, -1):
+            parents[state], levels[state] = parent, level
+        else:
+            assert level == 0 or parents[state] == parent, f"State {state} is in more than one cluster"
+
+    def visit(P, parent, level: int):
+        for node in P.get_node_list():
+            state = node.get_name().strip('"')
+            if state not in ("node", "graph", "edge"):
+                member(state, parent, level)
+                G.nodes[state].update(node.get_attributes())
+
+        for edge in P.get_edge_list():
+            S, N = edge.get_source().strip('"'), edge.get_destination().strip('"')
+            member(S, parent, level)
+            member(N, parent, level)
+            G.add_edge(S, N, **edge.get_attributes())
+
+        for subgraph in P.get_subgraph_list():
+            cluster = subgraph.get_name().strip('"')
+            if cluster.startswith("cluster_"):
+                state = cluster[len("cluster_") :]
+                member(state, parent, level)
+                visit(subgraph, state, level + 1)
+            else:
+                visit(subgraph, parent, level)
+
+    visit(P, None, 0)
+
+    return G, parents
+
+
+def labels(data: dict) -> list:
+    """Events listed in the label attribute of an edge"""
+    label = data.get("label", "").strip('"')
+    return [event.strip() for event in label.split(",") if event.strip()]
+
+
+def after(data: dict):
+    """Timeout in ms of an edge with the after attribute, e.g. after=200ms or after=2s, None otherwise"""
+    value = data.get("after", "").strip('"').strip()
+    if not value:
+        return None
+
+    match = re.fullmatch(r"(\d+)\s*(ms|s)", value)
+    assert match, f"after={value}: expected a duration such as 200ms or 2s"
+    return int(match[1]) * (1000 if match[2] == "s" else 1)
 
 
 @click.command()
 @click.argument("name", type=str)
 @click.argument("dot", type=click.File("r"))
-def main(name: str, dot: TextIOWrapper):
-    global source, header
+@click.option(
+    "--standalone",
+    is_flag=True,
+    help="Generate a self-contained machine with switch based dispatch and const tables, not using fsm.c",
+)
+@click.option(
+    "--harness",
+    is_flag=True,
+    help="Also generate <name>_harness/, a host program driving the machine with random or recorded events",
+)
+def main(name: str, dot: TextIOWrapper, standalone: bool, harness: bool):
+    global source, header, standalone_source, standalone_header, harness_source, harness_header
 
-    G = nx.drawing.nx_pydot.read_dot(dot)
-    assert nx.is_directed(G), "Graph must be directed"
+    P = pydot.graph_from_dot_data(dot.read())[0]
+    assert P.get_type() == "digraph", "Graph must be directed"
+    G, parents = load(P)
     assert nx.is_weakly_connected(G), "Graph must be weakly connected"
-    G = nx.MultiDiGraph(G)  # Cast to MultiDiGraph to allow parallel edges
 
     states = [state for state in G.nodes]
-    exits = {state: [N for _, N in G.out_edges(state)] for state in states}
+    assert len(states) < 256, "At most 255 states"
+
+    # Ancestors of every state, outermost first and the state itself last
+    paths = {}
+    for state in states:
+        path = [state]
+        while parents[path[0]] is not None:
+            assert parents[path[0]] not in path, f"Cluster of {state} contains itself"
+            path.insert(0, parents[path[0]])
+        paths[state] = path
+
+    # Number of ancestors in common, the exit and entry chains of a transition start below them.
+    # The target itself is never in common, so a transition to an ancestor exits and enters it again
+    def common(A: list, B: list) -> int:
+        n = 0
+        while n < min(len(A), len(B)) - 1 and A[n] == B[n]:
+            n += 1
+        return n
+
+    lca_depths = {S: {N: common(paths[S], paths[N]) for N in states} for S in states}
+    hierarchical = any(parent is not None for parent in parents.values())
+
+    # Timed transitions, e.g. SETUP -> ERROR [after=200ms], are taken by the engine and not by the state functions
+    timeouts = {}
+    for S, N, data in G.edges(data=True):
+        ms = after(data)
+        if ms is None:
+            continue
+        assert ms > 0, f"Edge {S} -> {N}: after must be positive"
+        assert not labels(data), f"Edge {S} -> {N}: an edge can have either a label or after"
+        assert S not in timeouts, f"State {S} has more than one after edge"
+        assert S not in parents.values(), f"Cluster {S} cannot have an after edge, only the current state is timed"
+        timeouts[S] = (ms, N)
+
+    # Parallel edges (e.g. one per event) lead to the same exit
+    exits = {
+        state: list(dict.fromkeys(N for _, N, data in G.out_edges(state, data=True) if after(data) is None))
+        for state in states
+    }
+    # A timed state waits for its deadline, so do_work may stay in it
+    for state in timeouts:
+        if state not in exits[state]:
+            exits[state].append(state)
+
+    # Edge labels name the events triggering the transition, e.g. RUN -> ERROR [label="fault,overheat"]
+    events = []
+    triggers = {state: {} for state in states}
+    for S, N, data in G.edges(data=True):
+        for event in labels(data):
+            assert event.isidentifier(), f"Edge {S} -> {N}: event '{event}' is not a valid C identifier"
+            if event not in events:
+                events.append(event)
+            targets = triggers[S].setdefault(event, [])
+            if N not in targets:
+                targets.append(N)
+
+    assert len(events) <= 32, "At most 32 events (FSM_MAX_EVENTS) can be named"
+
+    # States with poll=false have no do_work: FSM_is_ready, and so the scheduler, skip them until an event arrives
+    polling = {state: G.nodes[state].get("poll", "true").strip('"').lower() not in ("false", "0", "no") for state in states}
+
+    # Once events are named an edge without label belongs to do_work, so its source must have one
+    for S, N, data in G.edges(data=True):
+        if events and S != N and not labels(data) and after(data) is None:
+            assert polling[S], f"Edge {S} -> {N}: no event label and {S} has no do_work, no function can take it"
+
+    index = {event: i for i, event in enumerate(events)}
+    handled_masks = {state: sum(1 << index[event] for event in triggers[state]) for state in states}
 
     args = {
         "name": name,
         "states": states,
         "exits": exits,
+        "events": events,
+        "triggers": triggers,
+        "handled_masks": handled_masks,
+        "hierarchical": hierarchical,
+        "paths": paths,
+        "max_depth": max(len(path) for path in paths.values()),
+        "lca_depths": lca_depths,
+        "timeouts": timeouts,
+        "polling": polling,
     }
 
     cwd = Path.cwd()
 
+    if standalone:
+        assert not harness, "The harness drives the machine through fsm.c, it is not available for standalone machines"
+        assert len(states) <= 32, "Standalone machines support up to 32 states"
+        assert not timeouts, "after edges need the timer service of fsm.c, they are not supported by standalone machines"
+
+        bit = {state: 1 << i for i, state in enumerate(states)}
+        # A state without do_work stays where it is
+        args["work_exit_masks"] = {
+            state: sum(bit[N] for N in exits[state]) | (0 if polling[state] else bit[state]) for state in states
+        }
+        if events:
+            args["event_exit_masks"] = {
+                state: {event: sum(bit[N] for N in targets) | bit[state] for event, targets in triggers[state].items()}
+                for state in states
+            }
+        else:
+            args["event_exit_masks"] = {state: args["work_exit_masks"][state] | bit[state] for state in states}
+        args["name_len"] = max(len(state) for state in states) + 1
+
+        (cwd / f"{name}.c").write_text(standalone_source.render(**args))
+        (cwd / f"{name}.h").write_text(standalone_header.render(**args))
+        return
+
     (cwd / f"{name}.c").write_text(source.render(**args))
     (cwd / f"{name}.h").write_text(header.render(**args))
 
+    if harness:
+        # Staying in a state is not a transition, unless a timeout leaves and enters it again.
+        # Every edge keeps the mask of its events, 0 when any event or do_work can take it
+        args["coverage_edges"] = {}
+        for S, N, data in G.edges(data=True):
+            if S != N or after(data) is not None:
+                mask = sum(1 << index[event] for event in labels(data))
+                previous = args["coverage_edges"].get((S, N), mask)
+                args["coverage_edges"][(S, N)] = mask | previous if mask and previous else 0
+
+        (cwd / f"{name}_harness").mkdir(exist_ok=True)
+        (cwd / f"{name}_harness" / "harness.c").write_text(harness_source.render(**args))
+        (cwd / f"{name}_harness" / "main.h").write_text(harness_header.render(**args))
+
 
 if __name__ == "__main__":
     main()
@@ -0,0 +1,110 @@
+/*
+ * "THE BEER-WARE LICENSE" (Revision 69):
+ * Squadra Corse firmware team wrote this file. As long as you retain this notice
+ * you can do whatever you want with this stuff. If we meet some day, and you
+ * think this stuff is worth it, you can buy us a beer in return.
+ *
+ * Authors
+ * - Federico Carbone [federico.carbone.sc@gmail.com]
+ */
+
+/*
+ * Cycles of one FSM_routine call on a one state machine of 8 and 32 events,
+ * with no event pending, one and all of them. FSM_routine visits only the
+ * pending bits with CTZ; the reference loop scans every event like the
+ * routine did before. Best of ROUNDS averages of CALLS calls, with the cost
+ * of reading the cycle counter subtracted.
+ */
+
+#include "fsm.h"
+#include "host.h"
+
+#define ROUNDS 300
+#define CALLS  1000
+
+static volatile uint32_t sink;
+
+static uint32_t handler(uint8_t event) {
+    sink += event;
+    return 0;
+}
+
+static FSM_StateTypeDef states[1] = {{handler, NULL, NULL, NULL}};
+static FSM_ConfigTypeDef config   = {1, states, NULL, NULL, NULL};
+
+/* Dispatch before CTZ: every event bit is tested */
+__attribute__((noinline)) static void scan_routine(FSM_HandleTypeDef *handle) {
+    for (uint8_t event = 0; event < handle->events_length; ++event) {
+        uint32_t mask = 1U << event;
+        if ((handle->events_async ^ handle->events_sync) & mask) {
+            handle->events_sync ^= mask;
+            config.state_table[handle->current_state].event_handler(event);
+        }
+    }
+}
+
+static double overhead;
+
+static double run(uint8_t events, uint8_t fire, uint8_t scan) {
+    FSM_HandleTypeDef handle;
+    double best = 1e30;
+
+    HOST_CHECK(FSM_init(&handle, &config, events, NULL, NULL) == STMLIBS_OK);
+
+    for (uint32_t round = 0; round < ROUNDS; ++round) {
+        uint64_t total = 0;
+
+        for (uint32_t call = 0; call < CALLS; ++call) {
+            // Spread over the whole mask
+            for (uint8_t i = 0; i < fire; ++i) {
+                FSM_trigger_event(&handle, i * events / fire);
+            }
+
+            uint64_t start = host_cycles();
+            if (scan) {
+                scan_routine(&handle);
+            } else {
+                FSM_routine(&handle);
+            }
+            total += host_cycles() - start;
+        }
+
+        if ((double)total / CALLS < best) {
+            best = (double)total / CALLS;
+        }
+    }
+
+    HOST_CHECK((handle.events_async ^ handle.events_sync) == 0);
+
+    return best - overhead;
+}
+
+int main(void) {
+    overhead = 1e30;
+    for (uint32_t round = 0; round < ROUNDS; ++round) {
+        uint64_t total = 0;
+        for (uint32_t call = 0; call < CALLS; ++call) {
+            uint64_t start = host_cycles();
+            total += host_cycles() - start;
+        }
+        if ((double)total / CALLS < overhead) {
+            overhead = (double)total / CALLS;
+        }
+    }
+
+    printf("%-12s %-6s %8s %8s\n", "", "", "scan", "ctz");
+    for (uint8_t events = 8; events <= 32; events *= 4) {
+        static const char *const names[] = {"idle", "one", "all"};
+        uint8_t fires[]                  = {0, 1, events};
+
+        for (uint32_t i = 0; i < 3; ++i) {
+            printf("%2u events   %-6s %8.1f %8.1f\n",
+                   events,
+                   names[i],
+                   run(events, fires[i], 1),
+                   run(events, fires[i], 0));
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,67 @@
+/*
+ * "THE BEER-WARE LICENSE" (Revision 69):
+ * Squadra Corse firmware team wrote this file. As long as you retain this notice
+ * you can do whatever you want with this stuff. If we meet some day, and you
+ * think this stuff is worth it, you can buy us a beer in return.
+ *
+ * Authors
+ * - Federico Carbone [federico.carbone.sc@gmail.com]
+ */
+
+/*
+ * Event dispatch of FSM_routine: lowest pending event first, an event
+ * triggered twice before the routine runs is handled once, a transition ends
+ * the call and the other events wait for the next one.
+ */
+
+#include "fsm.h"
+#include "host.h"
+
+static uint32_t seen[64];
+static uint32_t seen_length;
+
+static uint32_t idle_handler(uint8_t event) {
+    seen[seen_length++] = event;
+    return event == 3 ? 1 : 0;
+}
+
+static uint32_t run_handler(uint8_t event) {
+    seen[seen_length++] = 100 + event;
+    return 1;
+}
+
+static FSM_StateTypeDef states[2] = {{idle_handler, NULL, NULL, NULL}, {run_handler, NULL, NULL, NULL}};
+static FSM_ConfigTypeDef config   = {2, states, NULL, NULL, NULL};
+
+int main(void) {
+    FSM_HandleTypeDef handle;
+
+    HOST_CHECK(FSM_init(&handle, &config, 32, NULL, NULL) == STMLIBS_OK);
+    HOST_CHECK(FSM_trigger_event(&handle, 32) == STMLIBS_ERROR);
+
+    HOST_CHECK(FSM_trigger_event(&handle, 31) == STMLIBS_OK);
+    HOST_CHECK(FSM_trigger_event(&handle, 3) == STMLIBS_OK);
+    HOST_CHECK(FSM_trigger_event(&handle, 1) == STMLIBS_OK);
+    HOST_CHECK(FSM_trigger_event(&handle, 3) == STMLIBS_OK);
+
+    // 1 then 3, which transitions: 31 is left for the next call
+    HOST_CHECK(FSM_routine(&handle) == STMLIBS_OK);
+    HOST_CHECK(seen_length == 2 && seen[0] == 1 && seen[1] == 3);
+    HOST_CHECK(FSM_get_state(&handle) == 1);
+
+    // Triggered again while pending: handled once
+    HOST_CHECK(FSM_trigger_event(&handle, 31) == STMLIBS_OK);
+    HOST_CHECK(FSM_routine(&handle) == STMLIBS_OK);
+    HOST_CHECK(seen_length == 3 && seen[2] == 131);
+
+    HOST_CHECK(FSM_routine(&handle) == STMLIBS_OK);
+    HOST_CHECK(seen_length == 3);
+
+    HOST_CHECK(FSM_trigger_event(&handle, 0) == STMLIBS_OK);
+    HOST_CHECK(FSM_routine(&handle) == STMLIBS_OK);
+    HOST_CHECK(seen_length == 4 && seen[3] == 100);
+
+    printf("fsm_test: ok\n");
+
+    return 0;
+}
@@ -0,0 +1,178 @@
+/*
+ * "THE BEER-WARE LICENSE" (Revision 69):
+ * Squadra Corse firmware team wrote this file. As long as you retain this notice
+ * you can do whatever you want with this stuff. If we meet some day, and you
+ * think this stuff is worth it, you can buy us a beer in return.
+ *
+ * Authors
+ * - Federico Carbone [federico.carbone.sc@gmail.com]
+ */
+
+/*
+ * Hierarchical states, with tables in the format fsmgen generates for
+ *
+ *     A { A1, A2 { A2x } }, B { B1 }
+ *
+ * A transition exits the states up to the common ancestor, innermost first,
+ * and enters the ones below it, outermost first. An event the current state
+ * does not handle bubbles to the nearest ancestor handling it, skipping the
+ * ones without a handler; a handler returning its own state does not
+ * transition, and an event nobody on the path handles is dropped.
+ */
+
+#include "fsm.h"
+#include "host.h"
+
+enum { A1, A2X, B1, A, A2, B, STATES };
+
+/* Entries are logged as ENTRY + state, exits as EXIT + state, handlers as HANDLER + 10 * state + event */
+#define ENTRY   100
+#define EXIT    200
+#define HANDLER 1000
+
+static uint32_t log_codes[16];
+static uint32_t log_length;
+
+static void append(uint32_t code) {
+    HOST_CHECK(log_length < sizeof(log_codes) / sizeof(log_codes[0]));
+    log_codes[log_length++] = code;
+}
+
+static void check_log(const uint32_t *expected, uint32_t length) {
+    HOST_CHECK(log_length == length);
+    for (uint32_t i = 0; i < length; ++i) {
+        HOST_CHECK(log_codes[i] == expected[i]);
+    }
+    log_length = 0;
+}
+
+#define STATE_FUNCTIONS(name)        \
+    static void name##_entry(void) { \
+        append(ENTRY + name);        \
+    }                                \
+    static void name##_exit(void) {  \
+        append(EXIT + name);         \
+    }
+
+STATE_FUNCTIONS(A1)
+STATE_FUNCTIONS(A2X)
+STATE_FUNCTIONS(B1)
+STATE_FUNCTIONS(A)
+STATE_FUNCTIONS(A2)
+STATE_FUNCTIONS(B)
+
+static uint32_t A1_handler(uint8_t event) {
+    append(HANDLER + 10 * A1 + event);
+    return A2X;
+}
+
+static uint32_t A2X_handler(uint8_t event) {
+    append(HANDLER + 10 * A2X + event);
+    return A2X;
+}
+
+static uint32_t B1_handler(uint8_t event) {
+    append(HANDLER + 10 * B1 + event);
+    return B;
+}
+
+static uint32_t A_handler(uint8_t event) {
+    append(HANDLER + 10 * A + event);
+    return event == 1 ? B1 : A;
+}
+
+static uint32_t B_handler(uint8_t event) {
+    append(HANDLER + 10 * B + event);
+    return B;
+}
+
+static FSM_StateTypeDef states[STATES] = {
+    [A1]  = {A1_handler, A1_entry, NULL, A1_exit},
+    [A2X] = {A2X_handler, A2X_entry, NULL, A2X_exit},
+    [B1]  = {B1_handler, B1_entry, NULL, B1_exit},
+    [A]   = {A_handler, A_entry, NULL, A_exit},
+    [A2]  = {NULL, A2_entry, NULL, A2_exit},
+    [B]   = {B_handler, B_entry, NULL, B_exit},
+};
+
+static const uint32_t event_masks[STATES] = {
+    [A1]  = 1U << 0,
+    [A2X] = 1U << 4,
+    [B1]  = 1U << 3,
+    [A]   = 1U << 1 | 1U << 4,
+    [A2]  = 0,
+    [B]   = 1U << 2,
+};
+
+static const uint8_t depths[STATES] = {[A1] = 2, [A2X] = 3, [B1] = 2, [A] = 1, [A2] = 2, [B] = 1};
+
+static const uint8_t paths[STATES * 3] = {
+    A, A1, 0,    // A1
+    A, A2, A2X,  // A2x
+    B, B1, 0,    // B1
+    A, 0, 0,     // A
+    A, A2, 0,    // A2
+    B, 0, 0,     // B
+};
+
+static const uint8_t lca_depths[STATES * STATES] = {
+    2, 1, 0, 1, 1, 0,  // A1
+    1, 3, 0, 1, 2, 0,  // A2x
+    0, 0, 2, 0, 0, 1,  // B1
+    1, 1, 0, 1, 1, 0,  // A
+    1, 2, 0, 1, 2, 0,  // A2
+    0, 0, 1, 0, 0, 1,  // B
+};
+
+static const FSM_HierarchyTypeDef hierarchy = {3, depths, paths, lca_depths};
+static FSM_ConfigTypeDef config             = {STATES, states, event_masks, &hierarchy, NULL};
+
+static FSM_HandleTypeDef handle;
+
+static void step(uint8_t event) {
+    HOST_CHECK(FSM_trigger_event(&handle, event) == STMLIBS_OK);
+    HOST_CHECK(FSM_routine(&handle) == STMLIBS_OK);
+}
+
+int main(void) {
+    HOST_CHECK(FSM_init(&handle, &config, 8, NULL, NULL) == STMLIBS_OK);
+
+    // Parents first
+    HOST_CHECK(FSM_start(&handle) == STMLIBS_OK);
+    check_log((const uint32_t[]){ENTRY + A, ENTRY + A1}, 2);
+
+    // Within A: only A1 is left, A2 and A2x are entered
+    step(0);
+    HOST_CHECK(FSM_get_state(&handle) == A2X);
+    check_log((const uint32_t[]){HANDLER + 10 * A1 + 0, EXIT + A1, ENTRY + A2, ENTRY + A2X}, 4);
+
+    // Handled by A2x itself before its ancestor A, no transition
+    step(4);
+    HOST_CHECK(FSM_get_state(&handle) == A2X);
+    check_log((const uint32_t[]){HANDLER + 10 * A2X + 4}, 1);
+
+    // Bubbles past A2, which has no handler, to A; every state of A is left, innermost first
+    step(1);
+    HOST_CHECK(FSM_get_state(&handle) == B1);
+    check_log((const uint32_t[]){HANDLER + 10 * A + 1, EXIT + A2X, EXIT + A2, EXIT + A, ENTRY + B, ENTRY + B1}, 6);
+
+    // Handled by the parent returning itself: stays in B1
+    step(2);
+    HOST_CHECK(FSM_get_state(&handle) == B1);
+    check_log((const uint32_t[]){HANDLER + 10 * B + 2}, 1);
+
+    // Nobody on the path handles 0, dropped
+    step(0);
+    HOST_CHECK(FSM_get_state(&handle) == B1);
+    check_log(NULL, 0);
+    HOST_CHECK(!FSM_is_ready(&handle));
+
+    // To the parent: B1 is exited, B is not entered again
+    step(3);
+    HOST_CHECK(FSM_get_state(&handle) == B);
+    check_log((const uint32_t[]){HANDLER + 10 * B1 + 3, EXIT + B1}, 2);
+
+    printf("hierarchy_test: ok\n");
+
+    return 0;
+}
@@ -0,0 +1,81 @@
+/*
+ * "THE BEER-WARE LICENSE" (Revision 69):
+ * Squadra Corse firmware team wrote this file. As long as you retain this notice
+ * you can do whatever you want with this stuff. If we meet some day, and you
+ * think this stuff is worth it, you can buy us a beer in return.
+ *
+ * Authors
+ * - Federico Carbone [federico.carbone.sc@gmail.com]
+ */
+
+/*
+ * FSM_SCHEDULER_routine sleeping in the default FSM_SCHEDULER_idle: a thread
+ * standing in for an interrupt posts an event every 200 us and raises the
+ * interrupt. The main loop handles every event, in order, and sleeps in
+ * between instead of spinning: at most three routine calls per interrupt,
+ * one running the machine and two for an interrupt raised while it was awake.
+ */
+
+#include "fsm_scheduler.h"
+#include "host.h"
+
+#define EVENTS 200
+/* Room for a main loop falling behind */
+#define QUEUE 64
+
+static FSM_HandleTypeDef fsm;
+static uint32_t handled;
+
+static uint32_t idle_handler(uint8_t event) {
+    (void)event;
+    HOST_CHECK(FSM_get_payload(&fsm) == handled);
+    ++handled;
+    return 0;
+}
+
+static FSM_StateTypeDef states[1] = {{idle_handler, NULL, NULL, NULL}};
+static FSM_ConfigTypeDef config   = {1, states, NULL, NULL, NULL};
+
+static void *interrupt(void *arg) {
+    (void)arg;
+
+    for (uint32_t i = 0; i < EVENTS; ++i) {
+        struct timespec period = {0, 200000};
+        nanosleep(&period, NULL);
+
+        HOST_CHECK(FSM_post_event(&fsm, 0, i) == STMLIBS_OK);
+        host_irq_raise();
+    }
+
+    return NULL;
+}
+
+int main(void) {
+    static FSM_EventTypeDef storage[QUEUE];
+    static CIRCULAR_BUFFER_MPSC_SequenceTypeDef sequences[QUEUE];
+    CIRCULAR_BUFFER_MPSC_HandleTypeDef queue;
+    FSM_SCHEDULER_HandleTypeDef scheduler;
+    pthread_t thread;
+
+    HOST_CHECK(CIRCULAR_BUFFER_MPSC_init(&queue, storage, sequences, QUEUE, sizeof(FSM_EventTypeDef)) == STMLIBS_OK);
+    HOST_CHECK(FSM_init(&fsm, &config, 1, NULL, NULL) == STMLIBS_OK);
+    HOST_CHECK(FSM_init_queue(&fsm, &queue) == STMLIBS_OK);
+    HOST_CHECK(FSM_start(&fsm) == STMLIBS_OK);
+    HOST_CHECK(FSM_SCHEDULER_init(&scheduler) == STMLIBS_OK);
+    HOST_CHECK(FSM_SCHEDULER_add(&scheduler, &fsm, 0) == STMLIBS_OK);
+
+    HOST_CHECK(pthread_create(&thread, NULL, interrupt, NULL) == 0);
+
+    uint32_t routines = 0;
+    while (handled < EVENTS) {
+        HOST_CHECK(FSM_SCHEDULER_routine(&scheduler) == STMLIBS_OK);
+        ++routines;
+    }
+
+    HOST_CHECK(pthread_join(thread, NULL) == 0);
+    HOST_CHECK(routines <= 3 * EVENTS);
+
+    printf("idle_test: %" PRIu32 " events in %" PRIu32 " routine calls\n", handled, routines);
+
+    return 0;
+}
@@ -0,0 +1,113 @@
+/*
+ * "THE BEER-WARE LICENSE" (Revision 69):
+ * Squadra Corse firmware team wrote this file. As long as you retain this notice
+ * you can do whatever you want with this stuff. If we meet some day, and you
+ * think this stuff is worth it, you can buy us a beer in return.
+ *
+ * Authors
+ * - Federico Carbone [federico.carbone.sc@gmail.com]
+ */
+
+/*
+ * Event queue of FSM_init_queue: posted events are handled in arrival order,
+ * once per post and each with its own payload, events past FSM_MAX_EVENTS
+ * included. A full queue rejects the post, and the events left behind by a
+ * transition are handled by the next state.
+ */
+
+#include "fsm.h"
+#include "host.h"
+
+#define EVENTS 40
+
+static FSM_HandleTypeDef handle;
+static uint32_t seen[64][2];
+static uint32_t seen_length;
+
+static uint32_t record(uint32_t state, uint8_t event) {
+    seen[seen_length][0] = event;
+    seen[seen_length][1] = FSM_get_payload(&handle);
+    ++seen_length;
+    return state;
+}
+
+static uint32_t idle_handler(uint8_t event) {
+    return record(event == 7 ? 1 : 0, event);
+}
+
+static uint32_t run_handler(uint8_t event) {
+    return record(1, event);
+}
+
+static FSM_StateTypeDef states[2] = {{idle_handler, NULL, NULL, NULL}, {run_handler, NULL, NULL, NULL}};
+static FSM_ConfigTypeDef config   = {2, states, NULL, NULL, NULL};
+
+static void check_seen(const uint32_t expected[][2], uint32_t length) {
+    HOST_CHECK(seen_length == length);
+    for (uint32_t i = 0; i < length; ++i) {
+        HOST_CHECK(seen[i][0] == expected[i][0] && seen[i][1] == expected[i][1]);
+    }
+    seen_length = 0;
+}
+
+int main(void) {
+    static FSM_EventTypeDef storage[4];
+    static CIRCULAR_BUFFER_MPSC_SequenceTypeDef sequences[4];
+    CIRCULAR_BUFFER_MPSC_HandleTypeDef queue = {0};
+
+    HOST_CHECK(FSM_init(&handle, &config, EVENTS, NULL, NULL) == STMLIBS_OK);
+    HOST_CHECK(FSM_post_event(&handle, 0, 0) == STMLIBS_ERROR);
+
+    // Never initialized, then initialized with the wrong element size
+    HOST_CHECK(FSM_init_queue(&handle, &queue) == STMLIBS_ERROR);
+    HOST_CHECK(CIRCULAR_BUFFER_MPSC_init(&queue, storage, sequences, 4, sizeof(uint32_t)) == STMLIBS_OK);
+    HOST_CHECK(FSM_init_queue(&handle, &queue) == STMLIBS_ERROR);
+    HOST_CHECK(CIRCULAR_BUFFER_MPSC_init(&queue, storage, sequences, 4, sizeof(FSM_EventTypeDef)) == STMLIBS_OK);
+    HOST_CHECK(FSM_init_queue(&handle, &queue) == STMLIBS_OK);
+    HOST_CHECK(FSM_start(&handle) == STMLIBS_OK);
+
+    HOST_CHECK(FSM_post_event(&handle, EVENTS, 0) == STMLIBS_ERROR);
+    HOST_CHECK(!FSM_is_ready(&handle));
+
+    // Arrival order, not event order, and a repeated event is handled twice
+    HOST_CHECK(FSM_post_event(&handle, 3, 30) == STMLIBS_OK);
+    HOST_CHECK(FSM_post_event(&handle, 1, 10) == STMLIBS_OK);
+    HOST_CHECK(FSM_post_event(&handle, 3, 31) == STMLIBS_OK);
+    HOST_CHECK(FSM_post_event(&handle, 35, 350) == STMLIBS_OK);
+    HOST_CHECK(FSM_is_ready(&handle));
+
+    // Full
+    HOST_CHECK(FSM_post_event(&handle, 2, 20) == STMLIBS_ERROR);
+
+    HOST_CHECK(FSM_routine(&handle) == STMLIBS_OK);
+    check_seen((const uint32_t[][2]){{3, 30}, {1, 10}, {3, 31}, {35, 350}}, 4);
+    HOST_CHECK(!FSM_is_ready(&handle));
+
+    // Emptied, posts are accepted again
+    HOST_CHECK(FSM_post_event(&handle, 2, 20) == STMLIBS_OK);
+    HOST_CHECK(FSM_routine(&handle) == STMLIBS_OK);
+    check_seen((const uint32_t[][2]){{2, 20}}, 1);
+
+    // Triggered events are handled before the queue and carry no payload
+    HOST_CHECK(FSM_post_event(&handle, 4, 40) == STMLIBS_OK);
+    HOST_CHECK(FSM_trigger_event(&handle, 5) == STMLIBS_OK);
+    HOST_CHECK(FSM_routine(&handle) == STMLIBS_OK);
+    check_seen((const uint32_t[][2]){{5, 0}, {4, 40}}, 2);
+
+    // 7 transitions: the events behind it are handled by the next state on the next call
+    HOST_CHECK(FSM_post_event(&handle, 6, 60) == STMLIBS_OK);
+    HOST_CHECK(FSM_post_event(&handle, 7, 70) == STMLIBS_OK);
+    HOST_CHECK(FSM_post_event(&handle, 8, 80) == STMLIBS_OK);
+    HOST_CHECK(FSM_post_event(&handle, 9, 90) == STMLIBS_OK);
+    HOST_CHECK(FSM_routine(&handle) == STMLIBS_OK);
+    HOST_CHECK(FSM_get_state(&handle) == 1);
+    check_seen((const uint32_t[][2]){{6, 60}, {7, 70}}, 2);
+
+    HOST_CHECK(FSM_routine(&handle) == STMLIBS_OK);
+    check_seen((const uint32_t[][2]){{8, 80}, {9, 90}}, 2);
+    HOST_CHECK(CIRCULAR_BUFFER_MPSC_is_empty(&queue));
+
+    printf("queue_test: ok\n");
+
+    return 0;
+}
@@ -0,0 +1,140 @@
+/*
+ * "THE BEER-WARE LICENSE" (Revision 69):
+ * Squadra Corse firmware team wrote this file. As long as you retain this notice
+ * you can do whatever you want with this stuff. If we meet some day, and you
+ * think this stuff is worth it, you can buy us a beer in return.
+ *
+ * Authors
+ * - Federico Carbone [federico.carbone.sc@gmail.com]
+ */
+
+/*
+ * Cycles of one FSM_SCHEDULER_dispatch call over N machines, against calling
+ * FSM_routine on each of them: all idle, one event for the lowest priority
+ * and every machine polling. The reference dispatch restarts from the highest
+ * priority after every run, like the scheduler did before. Best of ROUNDS
+ * averages of CALLS calls, with the cost of reading the cycle counter
+ * subtracted.
+ */
+
+#include "fsm_scheduler.h"
+#include "host.h"
+
+#define ROUNDS 200
+#define CALLS  1000
+
+static volatile uint32_t sink;
+
+static uint32_t idle_handler(uint8_t event) {
+    sink += event;
+    return 0;
+}
+
+static uint32_t busy_do_work(void) {
+    sink++;
+    return 0;
+}
+
+static FSM_StateTypeDef idle_states[1] = {{idle_handler, NULL, NULL, NULL}};
+static FSM_ConfigTypeDef idle_config   = {1, idle_states, NULL, NULL, NULL};
+static FSM_StateTypeDef busy_states[1] = {{idle_handler, NULL, busy_do_work, NULL}};
+static FSM_ConfigTypeDef busy_config   = {1, busy_states, NULL, NULL, NULL};
+
+static FSM_HandleTypeDef fsms[FSM_SCHEDULER_MAX_FSMS];
+static FSM_SCHEDULER_HandleTypeDef scheduler;
+static double overhead;
+
+/* Dispatch before the running index: back to the top after every run */
+__attribute__((noinline)) static uint8_t restart_dispatch(FSM_SCHEDULER_HandleTypeDef *handle) {
+    uint32_t ran = 0;
+    uint8_t runs = 0;
+
+    uint8_t i = 0;
+    while (i < handle->fsms_length) {
+        if ((ran & (1U << i)) || !FSM_is_ready(handle->fsms[i])) {
+            ++i;
+            continue;
+        }
+
+        FSM_routine(handle->fsms[i]);
+        ran |= 1U << i;
+        ++runs;
+        i = 0;
+    }
+
+    return runs;
+}
+
+enum { EACH, RESTART, DISPATCH };
+
+static double run(uint8_t n, FSM_ConfigTypeDef *config, uint8_t fire, uint8_t how) {
+    double best = 1e30;
+
+    HOST_CHECK(FSM_SCHEDULER_init(&scheduler) == STMLIBS_OK);
+    for (uint8_t i = 0; i < n; ++i) {
+        HOST_CHECK(FSM_init(&fsms[i], config, 1, NULL, NULL) == STMLIBS_OK);
+        HOST_CHECK(FSM_start(&fsms[i]) == STMLIBS_OK);
+        HOST_CHECK(FSM_SCHEDULER_add(&scheduler, &fsms[i], i) == STMLIBS_OK);
+    }
+
+    for (uint32_t round = 0; round < ROUNDS; ++round) {
+        uint64_t total = 0;
+
+        for (uint32_t call = 0; call < CALLS; ++call) {
+            // Priority 0, the lowest: visited last
+            if (fire) {
+                FSM_trigger_event(&fsms[0], 0);
+            }
+
+            uint64_t start = host_cycles();
+            if (how == EACH) {
+                for (uint8_t i = 0; i < n; ++i) {
+                    FSM_routine(&fsms[i]);
+                }
+            } else if (how == RESTART) {
+                restart_dispatch(&scheduler);
+            } else {
+                FSM_SCHEDULER_dispatch(&scheduler);
+            }
+            total += host_cycles() - start;
+        }
+
+        if ((double)total / CALLS < best) {
+            best = (double)total / CALLS;
+        }
+    }
+
+    return best - overhead;
+}
+
+int main(void) {
+    overhead = 1e30;
+    for (uint32_t round = 0; round < ROUNDS; ++round) {
+        uint64_t total = 0;
+        for (uint32_t call = 0; call < CALLS; ++call) {
+            uint64_t start = host_cycles();
+            total += host_cycles() - start;
+        }
+        if ((double)total / CALLS < overhead) {
+            overhead = (double)total / CALLS;
+        }
+    }
+
+    printf("%-12s %-8s %8s %8s %8s\n", "", "", "each", "restart", "dispatch");
+    static const uint8_t lengths[] = {1, 8, 32};
+    for (uint32_t i = 0; i < sizeof(lengths) / sizeof(lengths[0]); ++i) {
+        static const char *const names[] = {"idle", "one", "polling"};
+        FSM_ConfigTypeDef *configs[]     = {&idle_config, &idle_config, &busy_config};
+        static const uint8_t fires[]     = {0, 1, 0};
+
+        for (uint32_t j = 0; j < 3; ++j) {
+            printf("%2u machines  %-8s", lengths[i], names[j]);
+            for (uint8_t how = EACH; how <= DISPATCH; ++how) {
+                printf(" %8.1f", run(lengths[i], configs[j], fires[j], how));
+            }
+            printf("\n");
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,132 @@
+/*
+ * "THE BEER-WARE LICENSE" (Revision 69):
+ * Squadra Corse firmware team wrote this file. As long as you retain this notice
+ * you can do whatever you want with this stuff. If we meet some day, and you
+ * think this stuff is worth it, you can buy us a beer in return.
+ *
+ * Authors
+ * - Federico Carbone [federico.carbone.sc@gmail.com]
+ */
+
+/*
+ * FSM_SCHEDULER on three machines of priority 1, 5 and 3, each IDLE until the
+ * go event and then polling in BUSY: ready machines run once per pass in
+ * priority order, equal work does not starve anyone, a higher priority machine
+ * made ready by a lower one runs first in the next pass and FSM_SCHEDULER_idle
+ * is called only when nothing is ready.
+ */
+
+#include "fsm_scheduler.h"
+#include "host.h"
+
+#include <string.h>
+
+enum { IDLE, BUSY };
+enum { GO };
+
+static FSM_HandleTypeDef fsms[3];
+static char order[64];
+static uint32_t idles;
+static int32_t busy_left = 1000000;
+static uint8_t wake_first;
+
+void FSM_SCHEDULER_idle(void) {
+    ++idles;
+}
+
+static uint32_t idle_handler(uint8_t event) {
+    return event == GO ? BUSY : IDLE;
+}
+
+static uint32_t busy_do_work(void) {
+    return --busy_left > 0 ? BUSY : IDLE;
+}
+
+static FSM_StateTypeDef states[2] = {{idle_handler, NULL, NULL, NULL}, {idle_handler, NULL, busy_do_work, NULL}};
+static FSM_ConfigTypeDef config   = {2, states, NULL, NULL, NULL};
+
+static void ran(uint32_t id) {
+    char c[2] = {(char)('0' + id), 0};
+    strcat(order, c);
+}
+
+static void ran_0(uint32_t state) {
+    (void)state;
+    ran(0);
+    // The lowest priority wakes up the highest one, already visited in this pass
+    if (wake_first) {
+        HOST_CHECK(FSM_trigger_event(&fsms[1], GO) == STMLIBS_OK);
+    }
+}
+
+static void ran_1(uint32_t state) {
+    (void)state;
+    ran(1);
+}
+
+static void ran_2(uint32_t state) {
+    (void)state;
+    ran(2);
+}
+
+int main(void) {
+    FSM_SCHEDULER_HandleTypeDef scheduler;
+    FSM_callback_function callbacks[3] = {ran_0, ran_1, ran_2};
+    uint8_t priorities[3]              = {1, 5, 3};
+
+    HOST_CHECK(FSM_SCHEDULER_init(&scheduler) == STMLIBS_OK);
+    for (uint32_t i = 0; i < 3; ++i) {
+        HOST_CHECK(FSM_init(&fsms[i], &config, 1, callbacks[i], NULL) == STMLIBS_OK);
+        HOST_CHECK(FSM_start(&fsms[i]) == STMLIBS_OK);
+        HOST_CHECK(FSM_SCHEDULER_add(&scheduler, &fsms[i], priorities[i]) == STMLIBS_OK);
+    }
+
+    HOST_CHECK(FSM_SCHEDULER_dispatch(&scheduler) == 0);
+    HOST_CHECK(FSM_SCHEDULER_routine(&scheduler) == STMLIBS_OK);
+    HOST_CHECK(idles == 1);
+
+    // The events move every machine to BUSY, a transition returns before the run callback
+    for (uint32_t i = 0; i < 3; ++i) {
+        HOST_CHECK(FSM_trigger_event(&fsms[i], GO) == STMLIBS_OK);
+    }
+    HOST_CHECK(FSM_SCHEDULER_dispatch(&scheduler) == 3);
+    HOST_CHECK(strcmp(order, "") == 0);
+
+    // Then each one polls once per pass, highest priority first
+    for (uint32_t pass = 0; pass < 5; ++pass) {
+        HOST_CHECK(FSM_SCHEDULER_dispatch(&scheduler) == 3);
+    }
+    HOST_CHECK(strcmp(order, "120120120120120") == 0);
+
+    // The first to run goes back to IDLE, the others follow
+    busy_left = 1;
+    HOST_CHECK(FSM_SCHEDULER_dispatch(&scheduler) == 3);
+    HOST_CHECK(FSM_SCHEDULER_dispatch(&scheduler) == 0);
+    HOST_CHECK(FSM_SCHEDULER_routine(&scheduler) == STMLIBS_OK);
+    HOST_CHECK(idles == 2);
+
+    // Made ready after its turn, the highest priority waits for the next pass and leads it
+    busy_left = 1000000;
+    HOST_CHECK(FSM_trigger_event(&fsms[0], GO) == STMLIBS_OK);
+    HOST_CHECK(FSM_SCHEDULER_dispatch(&scheduler) == 1);
+    wake_first = 1;
+    HOST_CHECK(FSM_SCHEDULER_dispatch(&scheduler) == 1);
+    HOST_CHECK(FSM_get_state(&fsms[1]) == IDLE && FSM_is_ready(&fsms[1]));
+    wake_first = 0;
+    HOST_CHECK(FSM_SCHEDULER_dispatch(&scheduler) == 2);
+    order[0] = 0;
+    HOST_CHECK(FSM_SCHEDULER_dispatch(&scheduler) == 2);
+    HOST_CHECK(strcmp(order, "10") == 0);
+    HOST_CHECK(idles == 2);
+
+    FSM_HandleTypeDef extra;
+    HOST_CHECK(FSM_init(&extra, &config, 1, NULL, NULL) == STMLIBS_OK);
+    for (uint32_t i = 3; i < FSM_SCHEDULER_MAX_FSMS; ++i) {
+        HOST_CHECK(FSM_SCHEDULER_add(&scheduler, &extra, 0) == STMLIBS_OK);
+    }
+    HOST_CHECK(FSM_SCHEDULER_add(&scheduler, &extra, 0) == STMLIBS_ERROR);
+
+    printf("scheduler_test: ok\n");
+
+    return 0;
+}
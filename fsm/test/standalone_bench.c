@@ -0,0 +1,143 @@
+/*
+ * "THE BEER-WARE LICENSE" (Revision 69):
+ * Squadra Corse firmware team wrote this file. As long as you retain this notice
+ * you can do whatever you want with this stuff. If we meet some day, and you
+ * think this stuff is worth it, you can buy us a beer in return.
+ *
+ * Authors
+ * - Federico Carbone [federico.carbone.sc@gmail.com]
+ */
+
+/*
+ * Cycles of one routine call of the machine of fsmgen/example.dot generated
+ * twice, as "generic" on top of fsm.c and as "standalone" with --standalone,
+ * with no event pending, one and 8 of them, and the RAM and const tables of
+ * each. Both machines sit in RUN, whose handlers stay there. Best of ROUNDS
+ * averages of CALLS calls, with the cost of reading the cycle counter
+ * subtracted. Built only when FSMGEN is given to make.
+ */
+
+#include "generic.h"
+#include "host.h"
+#include "standalone.h"
+
+#define ROUNDS 300
+#define CALLS  1000
+#define EVENTS 8
+
+static volatile uint32_t sink;
+
+FSM_GENERIC_StateTypeDef FSM_GENERIC_START_do_work() {
+    return FSM_GENERIC_SETUP;
+}
+
+FSM_GENERIC_StateTypeDef FSM_GENERIC_SETUP_do_work() {
+    return FSM_GENERIC_RUN;
+}
+
+FSM_GENERIC_StateTypeDef FSM_GENERIC_RUN_event_handle(uint8_t event) {
+    sink += event;
+    return FSM_GENERIC_RUN;
+}
+
+FSM_GENERIC_StateTypeDef FSM_GENERIC_RUN_do_work() {
+    sink++;
+    return FSM_GENERIC_RUN;
+}
+
+FSM_STANDALONE_StateTypeDef FSM_STANDALONE_START_do_work() {
+    return FSM_STANDALONE_SETUP;
+}
+
+FSM_STANDALONE_StateTypeDef FSM_STANDALONE_SETUP_do_work() {
+    return FSM_STANDALONE_RUN;
+}
+
+FSM_STANDALONE_StateTypeDef FSM_STANDALONE_RUN_event_handle(uint8_t event) {
+    sink += event;
+    return FSM_STANDALONE_RUN;
+}
+
+FSM_STANDALONE_StateTypeDef FSM_STANDALONE_RUN_do_work() {
+    sink++;
+    return FSM_STANDALONE_RUN;
+}
+
+static FSM_HandleTypeDef generic;
+static FSM_STANDALONE_HandleTypeDef standalone;
+static double overhead;
+
+static double run(uint8_t fire, uint8_t use_standalone) {
+    double best = 1e30;
+
+    for (uint32_t round = 0; round < ROUNDS; ++round) {
+        uint64_t total = 0;
+
+        for (uint32_t call = 0; call < CALLS; ++call) {
+            for (uint8_t event = 0; event < fire; ++event) {
+                if (use_standalone) {
+                    FSM_STANDALONE_trigger_event(&standalone, event);
+                } else {
+                    FSM_trigger_event(&generic, event);
+                }
+            }
+
+            uint64_t start = host_cycles();
+            if (use_standalone) {
+                FSM_STANDALONE_routine(&standalone);
+            } else {
+                FSM_routine(&generic);
+            }
+            total += host_cycles() - start;
+        }
+
+        if ((double)total / CALLS < best) {
+            best = (double)total / CALLS;
+        }
+    }
+
+    return best - overhead;
+}
+
+int main(void) {
+    HOST_CHECK(FSM_GENERIC_init(&generic, EVENTS, NULL, NULL) == STMLIBS_OK);
+    HOST_CHECK(FSM_start(&generic) == STMLIBS_OK);
+    HOST_CHECK(FSM_STANDALONE_init(&standalone, EVENTS, NULL, NULL) == STMLIBS_OK);
+    HOST_CHECK(FSM_STANDALONE_start(&standalone) == STMLIBS_OK);
+
+    // START -> SETUP -> RUN
+    for (uint32_t i = 0; i < 2; ++i) {
+        FSM_routine(&generic);
+        FSM_STANDALONE_routine(&standalone);
+    }
+    HOST_CHECK(FSM_get_state(&generic) == FSM_GENERIC_RUN);
+    HOST_CHECK(FSM_STANDALONE_get_state(&standalone) == FSM_STANDALONE_RUN);
+
+    overhead = 1e30;
+    for (uint32_t round = 0; round < ROUNDS; ++round) {
+        uint64_t total = 0;
+        for (uint32_t call = 0; call < CALLS; ++call) {
+            uint64_t start = host_cycles();
+            total += host_cycles() - start;
+        }
+        if ((double)total / CALLS < overhead) {
+            overhead = (double)total / CALLS;
+        }
+    }
+
+    printf("%-10s %10s %10s\n", "", "generic", "standalone");
+    static const char *const names[] = {"idle", "one", "8 events"};
+    static const uint8_t fires[]     = {0, 1, EVENTS};
+    for (uint32_t i = 0; i < 3; ++i) {
+        printf("%-10s %10.1f %10.1f\n", names[i], run(fires[i], 0), run(fires[i], 1));
+    }
+
+    HOST_CHECK(FSM_get_state(&generic) == FSM_GENERIC_RUN);
+    HOST_CHECK(FSM_STANDALONE_get_state(&standalone) == FSM_STANDALONE_RUN);
+
+    // The generic machine also needs its FSM_ConfigTypeDef and state table, whose size is not exported
+    printf("RAM        %10zu %10zu bytes\n", sizeof(FSM_HandleTypeDef), FSM_STANDALONE_RAM_BYTES);
+    printf("tables     %10s %10" PRIu32 " bytes\n", "-", FSM_STANDALONE_table_bytes());
+
+    return 0;
+}
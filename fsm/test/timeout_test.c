@@ -0,0 +1,129 @@
+/*
+ * "THE BEER-WARE LICENSE" (Revision 69):
+ * Squadra Corse firmware team wrote this file. As long as you retain this notice
+ * you can do whatever you want with this stuff. If we meet some day, and you
+ * think this stuff is worth it, you can buy us a beer in return.
+ *
+ * Authors
+ * - Federico Carbone [federico.carbone.sc@gmail.com]
+ */
+
+/*
+ * State timeouts serviced by a FSM_TimerTypeDef ticking every 10 ms: a 30 ms
+ * timeout fires on the fourth tick after the entry, never earlier, also when
+ * the time wraps around. Leaving the state cancels it, even when it already
+ * expired and an event is handled first, and entering the state again arms
+ * it from the time of the new entry.
+ */
+
+#include "fsm.h"
+#include "host.h"
+
+#define PERIOD_MS 10
+
+enum { IDLE, WAIT, FAULT, STATES };
+
+static uint32_t idle_handler(uint8_t event) {
+    return event == 0 ? WAIT : IDLE;
+}
+
+static uint32_t wait_handler(uint8_t event) {
+    return event == 1 ? IDLE : WAIT;
+}
+
+static uint32_t fault_handler(uint8_t event) {
+    return event == 1 ? IDLE : FAULT;
+}
+
+static FSM_StateTypeDef states[STATES] = {
+    [IDLE]  = {idle_handler, NULL, NULL, NULL},
+    [WAIT]  = {wait_handler, NULL, NULL, NULL},
+    [FAULT] = {fault_handler, NULL, NULL, NULL},
+};
+
+static const FSM_TimeoutTypeDef timeouts[STATES] = {
+    [IDLE]  = {30, FAULT},
+    [WAIT]  = {0, 0},
+    [FAULT] = {0, 0},
+};
+
+static FSM_ConfigTypeDef config = {STATES, states, NULL, NULL, timeouts};
+static FSM_HandleTypeDef handle;
+static FSM_TimerTypeDef timer;
+static uint32_t transitions;
+
+static void transition_callback(uint32_t state) {
+    (void)state;
+    ++transitions;
+}
+
+/* Ticks, with a routine call after each, until a transition or ticks have passed */
+static uint32_t ticks_to_transition(uint32_t ticks) {
+    uint32_t before = transitions;
+
+    for (uint32_t i = 1; i <= ticks; ++i) {
+        HOST_CHECK(FSM_timer_tick(&timer) == STMLIBS_OK);
+        HOST_CHECK(FSM_routine(&handle) == STMLIBS_OK);
+        if (transitions != before) {
+            return i;
+        }
+    }
+
+    return 0;
+}
+
+static void step(uint8_t event) {
+    HOST_CHECK(FSM_trigger_event(&handle, event) == STMLIBS_OK);
+    HOST_CHECK(FSM_routine(&handle) == STMLIBS_OK);
+}
+
+int main(void) {
+    HOST_CHECK(FSM_timer_init(&timer, 0) == STMLIBS_ERROR);
+    HOST_CHECK(FSM_timer_init(&timer, PERIOD_MS) == STMLIBS_OK);
+    HOST_CHECK(FSM_init(&handle, &config, 2, NULL, transition_callback) == STMLIBS_OK);
+    HOST_CHECK(FSM_attach_timer(&handle, &timer) == STMLIBS_OK);
+    HOST_CHECK(FSM_attach_timer(&handle, &timer) == STMLIBS_ERROR);
+
+    // The deadline lies past the wrap around of now
+    timer.now = UINT32_MAX - 15;
+    HOST_CHECK(FSM_start(&handle) == STMLIBS_OK);
+    HOST_CHECK(!FSM_is_ready(&handle));
+
+    // The entry happened up to one period after now: 30 ms are sure to have passed only after four ticks
+    HOST_CHECK(ticks_to_transition(3) == 0);
+    HOST_CHECK(!FSM_is_ready(&handle));
+    HOST_CHECK(ticks_to_transition(1) == 1);
+    HOST_CHECK(FSM_get_state(&handle) == FAULT);
+
+    // Left before the deadline: nothing fires in WAIT
+    step(1);
+    HOST_CHECK(FSM_get_state(&handle) == IDLE);
+    HOST_CHECK(ticks_to_transition(2) == 0);
+    step(0);
+    HOST_CHECK(FSM_get_state(&handle) == WAIT);
+    HOST_CHECK(ticks_to_transition(100) == 0);
+    HOST_CHECK(!FSM_is_ready(&handle));
+
+    // Entered again: the full timeout from the new entry, the old deadline is gone
+    step(1);
+    HOST_CHECK(FSM_get_state(&handle) == IDLE);
+    HOST_CHECK(ticks_to_transition(4) == 4);
+    HOST_CHECK(FSM_get_state(&handle) == FAULT);
+
+    // Expired, but an event leaves the state first: the timeout is dropped with it
+    step(1);
+    HOST_CHECK(FSM_get_state(&handle) == IDLE);
+    for (uint32_t i = 0; i < 4; ++i) {
+        HOST_CHECK(FSM_timer_tick(&timer) == STMLIBS_OK);
+    }
+    HOST_CHECK(handle.timer_expired && FSM_is_ready(&handle));
+    step(0);
+    HOST_CHECK(FSM_get_state(&handle) == WAIT);
+    HOST_CHECK(!FSM_is_ready(&handle));
+    HOST_CHECK(ticks_to_transition(100) == 0);
+    HOST_CHECK(FSM_get_state(&handle) == WAIT);
+
+    printf("timeout_test: ok\n");
+
+    return 0;
+}
@@ -0,0 +1,108 @@
+# "THE BEER-WARE LICENSE" (Revision 69):
+# Squadra Corse firmware team wrote this file. As long as you retain this notice
+# you can do whatever you want with this stuff. If we meet some day, and you
+# think this stuff is worth it, you can buy us a beer in return.
+
+import struct
+from typing import BinaryIO, Iterator, Optional
+
+import click
+
+# Must match LOGGER_MODE and the prefixes in logger.c
+MODES = {
+    0: ("[INFO]", "\x1b[0;42m"),
+    1: ("[DBG]", "\x1b[0;47m"),
+    2: ("[WRN]", "\x1b[0;43m"),
+    3: ("[ERR]", "\x1b[0;41m"),
+    4: (None, None),
+}
+RESET = "\x1b[0m"
+
+HEADER = struct.Struct("<BHIB")
+CRC_LEN = 2
+FLAG_US = 0x01
+
+
+def crc16(data: bytes) -> int:
+    """CRC-16/CCITT-FALSE, same as _LOGGER_crc16"""
+    crc = 0xFFFF
+    for byte in data:
+        crc ^= byte << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else crc << 1
+            crc &= 0xFFFF
+    return crc
+
+
+def cobs_decode(data: bytes) -> Optional[bytes]:
+    out = bytearray()
+    i = 0
+    while i < len(data):
+        code = data[i]
+        if code == 0 or i + code > len(data):
+            return None
+        out += data[i + 1 : i + code]
+        i += code
+        if code != 0xFF and i < len(data):
+            out.append(0)
+    return bytes(out)
+
+
+def valid(raw: bytes) -> bool:
+    if len(raw) < HEADER.size + CRC_LEN:
+        return False
+    return crc16(raw[:-CRC_LEN]) == int.from_bytes(raw[-CRC_LEN:], "little")
+
+
+def frames(stream: BinaryIO) -> Iterator[bytes]:
+    """Split the stream on the 0x00 delimiter, a partial first frame is dropped by the CRC check"""
+    pending = bytearray()
+    read = stream.read1 if hasattr(stream, "read1") else stream.read
+    while chunk := read(4096):
+        pending += chunk
+        *complete, pending = pending.split(b"\x00")
+        pending = bytearray(pending)
+        yield from (bytes(frame) for frame in complete if frame)
+
+
+@click.command()
+@click.argument("input", type=click.File("rb"), default="-")
+@click.option("--color/--no-color", default=True, help="Reconstruct the ANSI colored prefixes")
+def main(input: BinaryIO, color: bool):
+    """Decode LOGGER_OUTPUT_FRAMED records read from INPUT (a file, a serial device or stdin)"""
+
+    expected = None
+    corrupt = 0
+    lost = 0
+
+    for encoded in frames(input):
+        raw = cobs_decode(encoded)
+        if raw is None or not valid(raw):
+            corrupt += 1
+            click.secho(f"<corrupt frame, {len(encoded)} bytes>", fg="red", err=True)
+            continue
+
+        mode, sequence, timestamp, flags = HEADER.unpack_from(raw)
+        text = raw[HEADER.size : -CRC_LEN].decode("utf-8", errors="replace")
+
+        if expected is not None and sequence != expected:
+            gap = (sequence - expected) & 0xFFFF
+            lost += gap
+            click.secho(f"<{gap} records lost>", fg="yellow", err=True)
+        expected = (sequence + 1) & 0xFFFF
+
+        prefix, ansi = MODES.get(mode, (f"[MODE {mode}]", ""))
+        if prefix is None:
+            click.echo(text, nl=False)
+            continue
+
+        if color and ansi:
+            prefix = f"{ansi}{prefix}{RESET}"
+        stamp = f"{timestamp:10}" if flags & FLAG_US else f"{timestamp:5}"
+        click.echo(f"\r\n{prefix}[{stamp}] {text}", nl=False)
+
+    click.echo(f"\r\n{corrupt} corrupt frames, {lost} records lost", err=True)
+
+
+if __name__ == "__main__":
+    main()
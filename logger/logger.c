@@ -29,6 +29,349 @@
 #define LOGGER_WARNING_STRING YELLOW_BG("[WRN]")
 #define LOGGER_ERROR_STRING   RED_BG("[ERR]")
 
+static const char *const _LOGGER_prefixes[] = {
+    [LOGGER_INFO]    = LOGGER_INFO_STRING,
+    [LOGGER_DEBUG]   = LOGGER_DEBUG_STRING,
+    [LOGGER_WARNING] = LOGGER_WARNING_STRING,
+    [LOGGER_ERROR]   = LOGGER_ERROR_STRING,
+};
+
+static const uint8_t _LOGGER_prefixes_len[] = {
+    [LOGGER_INFO]    = sizeof(LOGGER_INFO_STRING) - 1,
+    [LOGGER_DEBUG]   = sizeof(LOGGER_DEBUG_STRING) - 1,
+    [LOGGER_WARNING] = sizeof(LOGGER_WARNING_STRING) - 1,
+    [LOGGER_ERROR]   = sizeof(LOGGER_ERROR_STRING) - 1,
+};
+
+/* "\r\n" + longest prefix + "[" + timestamp + "] " */
+#define LOGGER_HEADER_MAX_LEN (2 + sizeof(LOGGER_INFO_STRING) - 1 + 1 + 10 + 2)
+
+/* mode, sequence number, timestamp, flags */
+#define LOGGER_FRAME_HEADER_LEN  8
+#define LOGGER_FRAME_CRC_LEN     2
+#define LOGGER_FRAME_FLAG_US     0x01U
+#define LOGGER_FRAME_RAW_MAX_LEN (LOGGER_FRAME_HEADER_LEN + LOGGER_DEFERRED_LINE_LEN + LOGGER_FRAME_CRC_LEN)
+/* COBS adds a code byte every 254 bytes, plus the first one and the delimiter */
+#define LOGGER_FRAME_MAX_LEN (LOGGER_FRAME_RAW_MAX_LEN + LOGGER_FRAME_RAW_MAX_LEN / 254 + 2)
+
+/* CRC-16/CCITT-FALSE, polynomial 0x1021 */
+static const uint16_t _LOGGER_crc16_table[256] = {
+    0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+    0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF,
+    0x1231, 0x0210, 0x3273, 0x2252, 0x52B5, 0x4294, 0x72F7, 0x62D6,
+    0x9339, 0x8318, 0xB37B, 0xA35A, 0xD3BD, 0xC39C, 0xF3FF, 0xE3DE,
+    0x2462, 0x3443, 0x0420, 0x1401, 0x64E6, 0x74C7, 0x44A4, 0x5485,
+    0xA56A, 0xB54B, 0x8528, 0x9509, 0xE5EE, 0xF5CF, 0xC5AC, 0xD58D,
+    0x3653, 0x2672, 0x1611, 0x0630, 0x76D7, 0x66F6, 0x5695, 0x46B4,
+    0xB75B, 0xA77A, 0x9719, 0x8738, 0xF7DF, 0xE7FE, 0xD79D, 0xC7BC,
+    0x48C4, 0x58E5, 0x6886, 0x78A7, 0x0840, 0x1861, 0x2802, 0x3823,
+    0xC9CC, 0xD9ED, 0xE98E, 0xF9AF, 0x8948, 0x9969, 0xA90A, 0xB92B,
+    0x5AF5, 0x4AD4, 0x7AB7, 0x6A96, 0x1A71, 0x0A50, 0x3A33, 0x2A12,
+    0xDBFD, 0xCBDC, 0xFBBF, 0xEB9E, 0x9B79, 0x8B58, 0xBB3B, 0xAB1A,
+    0x6CA6, 0x7C87, 0x4CE4, 0x5CC5, 0x2C22, 0x3C03, 0x0C60, 0x1C41,
+    0xEDAE, 0xFD8F, 0xCDEC, 0xDDCD, 0xAD2A, 0xBD0B, 0x8D68, 0x9D49,
+    0x7E97, 0x6EB6, 0x5ED5, 0x4EF4, 0x3E13, 0x2E32, 0x1E51, 0x0E70,
+    0xFF9F, 0xEFBE, 0xDFDD, 0xCFFC, 0xBF1B, 0xAF3A, 0x9F59, 0x8F78,
+    0x9188, 0x81A9, 0xB1CA, 0xA1EB, 0xD10C, 0xC12D, 0xF14E, 0xE16F,
+    0x1080, 0x00A1, 0x30C2, 0x20E3, 0x5004, 0x4025, 0x7046, 0x6067,
+    0x83B9, 0x9398, 0xA3FB, 0xB3DA, 0xC33D, 0xD31C, 0xE37F, 0xF35E,
+    0x02B1, 0x1290, 0x22F3, 0x32D2, 0x4235, 0x5214, 0x6277, 0x7256,
+    0xB5EA, 0xA5CB, 0x95A8, 0x8589, 0xF56E, 0xE54F, 0xD52C, 0xC50D,
+    0x34E2, 0x24C3, 0x14A0, 0x0481, 0x7466, 0x6447, 0x5424, 0x4405,
+    0xA7DB, 0xB7FA, 0x8799, 0x97B8, 0xE75F, 0xF77E, 0xC71D, 0xD73C,
+    0x26D3, 0x36F2, 0x0691, 0x16B0, 0x6657, 0x7676, 0x4615, 0x5634,
+    0xD94C, 0xC96D, 0xF90E, 0xE92F, 0x99C8, 0x89E9, 0xB98A, 0xA9AB,
+    0x5844, 0x4865, 0x7806, 0x6827, 0x18C0, 0x08E1, 0x3882, 0x28A3,
+    0xCB7D, 0xDB5C, 0xEB3F, 0xFB1E, 0x8BF9, 0x9BD8, 0xABBB, 0xBB9A,
+    0x4A75, 0x5A54, 0x6A37, 0x7A16, 0x0AF1, 0x1AD0, 0x2AB3, 0x3A92,
+    0xFD2E, 0xED0F, 0xDD6C, 0xCD4D, 0xBDAA, 0xAD8B, 0x9DE8, 0x8DC9,
+    0x7C26, 0x6C07, 0x5C64, 0x4C45, 0x3CA2, 0x2C83, 0x1CE0, 0x0CC1,
+    0xEF1F, 0xFF3E, 0xCF5D, 0xDF7C, 0xAF9B, 0xBFBA, 0x8FD9, 0x9FF8,
+    0x6E17, 0x7E36, 0x4E55, 0x5E74, 0x2E93, 0x3EB2, 0x0ED1, 0x1EF0,
+};
+
+static const uint32_t _LOGGER_pow10[] = {1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000};
+
+static inline uint8_t _LOGGER_is_filtered(LOGGER_HandleTypeDef *handle, LOGGER_MODE mode) {
+    return LOGGER_level_of(mode) < handle->threshold;
+}
+
+static inline LOGGER_TimestampTypeDef _LOGGER_timestamp(LOGGER_HandleTypeDef *handle) {
+    if (handle->clock != NULL) {
+        return handle->clock();
+    }
+
+    return HAL_GetTick();
+}
+
+/**
+ * @brief     Write the line header, LOGGER_HEADER_MAX_LEN characters at most
+ * @return    number of characters written, 0 for LOGGER_RAW
+ */
+static uint32_t _LOGGER_write_header(LOGGER_HandleTypeDef *handle,
+                                     char *dst,
+                                     LOGGER_MODE mode,
+                                     LOGGER_TimestampTypeDef timestamp) {
+    if (mode >= LOGGER_RAW) {
+        return 0;
+    }
+
+    uint32_t len = 0;
+
+    dst[len++] = '\r';
+    dst[len++] = '\n';
+    memcpy(dst + len, _LOGGER_prefixes[mode], _LOGGER_prefixes_len[mode]);
+    len += _LOGGER_prefixes_len[mode];
+    dst[len++] = '[';
+    len += LOGGER_format_u32(dst + len, timestamp, handle->microseconds ? 10 : 5);
+    dst[len++] = ']';
+    dst[len++] = ' ';
+
+    return len;
+}
+
+static uint16_t _LOGGER_crc16(const uint8_t *data, uint32_t len) {
+    uint16_t crc = 0xFFFF;
+
+    while (len--) {
+        crc = (crc << 8) ^ _LOGGER_crc16_table[(crc >> 8) ^ *data++];
+    }
+
+    return crc;
+}
+
+/**
+ * @brief     COBS encode src into dst followed by the 0x00 frame delimiter,
+ *                dst must hold len + len / 254 + 2 bytes
+ * @return    number of bytes written
+ */
+static uint32_t _LOGGER_cobs_encode(const uint8_t *src, uint32_t len, uint8_t *dst) {
+    uint32_t code_index = 0;
+    uint32_t out        = 1;
+    uint8_t code        = 1;
+
+    for (uint32_t i = 0; i < len; ++i) {
+        if (src[i] != 0) {
+            dst[out++] = src[i];
+            ++code;
+        }
+
+        if (src[i] == 0 || code == 0xFF) {
+            dst[code_index] = code;
+            code_index      = out++;
+            code            = 1;
+        }
+    }
+
+    dst[code_index] = code;
+    dst[out++]      = 0;
+
+    return out;
+}
+
+/**
+ * @brief     COBS encode a frame carrying text, text_len is capped at LOGGER_DEFERRED_LINE_LEN
+ * @param     dst Destination of LOGGER_FRAME_MAX_LEN bytes
+ * @return    number of bytes written, delimiter included
+ */
+static uint32_t _LOGGER_encode_frame(LOGGER_HandleTypeDef *handle,
+                                     uint8_t *dst,
+                                     LOGGER_MODE mode,
+                                     uint16_t sequence,
+                                     LOGGER_TimestampTypeDef timestamp,
+                                     const char *text,
+                                     uint32_t text_len) {
+    uint8_t raw[LOGGER_FRAME_RAW_MAX_LEN];
+
+    if (text_len > LOGGER_DEFERRED_LINE_LEN) {
+        text_len = LOGGER_DEFERRED_LINE_LEN;
+    }
+
+    uint32_t raw_len = LOGGER_FRAME_HEADER_LEN + text_len + LOGGER_FRAME_CRC_LEN;
+
+    // Little endian fields
+    raw[0] = mode;
+    raw[1] = sequence & 0xFF;
+    raw[2] = sequence >> 8;
+    raw[3] = timestamp & 0xFF;
+    raw[4] = (timestamp >> 8) & 0xFF;
+    raw[5] = (timestamp >> 16) & 0xFF;
+    raw[6] = timestamp >> 24;
+    raw[7] = handle->microseconds ? LOGGER_FRAME_FLAG_US : 0;
+    memcpy(raw + LOGGER_FRAME_HEADER_LEN, text, text_len);
+
+    uint16_t crc                                = _LOGGER_crc16(raw, raw_len - LOGGER_FRAME_CRC_LEN);
+    raw[LOGGER_FRAME_HEADER_LEN + text_len]     = crc & 0xFF;
+    raw[LOGGER_FRAME_HEADER_LEN + text_len + 1] = crc >> 8;
+
+    return _LOGGER_cobs_encode(raw, raw_len, dst);
+}
+
+/**
+ * @brief     Append a framed record to the buffer. The frame is encoded outside
+ *                of the critical section with the next sequence number, and
+ *                encoded again if a preempting context took that number before
+ *                the copy. The sequence number advances only when the frame is written.
+ */
+static STMLIBS_StatusTypeDef _LOGGER_write_frame(LOGGER_HandleTypeDef *handle,
+                                                 LOGGER_MODE mode,
+                                                 LOGGER_TimestampTypeDef timestamp,
+                                                 const char *text,
+                                                 uint32_t text_len) {
+    uint8_t frame[LOGGER_FRAME_MAX_LEN];
+    STMLIBS_StatusTypeDef errorcode = STMLIBS_OK;
+    uint8_t written                 = 0;
+
+    while (!written) {
+        uint16_t sequence = handle->sequence;
+        uint32_t len      = _LOGGER_encode_frame(handle, frame, mode, sequence, timestamp, text, text_len);
+
+        CS_ENTER();
+        if (handle->sequence == sequence) {
+            if (handle->index + len >= handle->buffer_len) {
+                errorcode = STMLIBS_ERROR;
+            } else {
+                memcpy(handle->buffer + handle->index, frame, len);
+                handle->index += len;
+                ++handle->sequence;
+            }
+            written = 1;
+        }
+        CS_EXIT();
+    }
+
+    return errorcode;
+}
+
+/**
+ * @brief     Append a complete line, as text with its header or as a frame
+ * @return    STMLIBS_ERROR if it does not fit the buffer, the caller may retry later
+ */
+static STMLIBS_StatusTypeDef _LOGGER_emit(LOGGER_HandleTypeDef *handle,
+                                          LOGGER_MODE mode,
+                                          LOGGER_TimestampTypeDef timestamp,
+                                          const char *text,
+                                          uint32_t text_len) {
+    if (handle->output == LOGGER_OUTPUT_FRAMED) {
+        return _LOGGER_write_frame(handle, mode, timestamp, text, text_len);
+    }
+
+    STMLIBS_StatusTypeDef errorcode = STMLIBS_OK;
+
+    CS_ENTER();
+
+    if (handle->index + LOGGER_HEADER_MAX_LEN + text_len >= handle->buffer_len) {
+        errorcode = STMLIBS_ERROR;
+    } else {
+        handle->index += _LOGGER_write_header(handle, handle->buffer + handle->index, mode, timestamp);
+        memcpy(handle->buffer + handle->index, text, text_len);
+        handle->index += text_len;
+    }
+
+    CS_EXIT();
+
+    return errorcode;
+}
+
+/**
+ * @brief     _LOGGER_emit for a line that is lost when it does not fit. Its
+ *                sequence number is consumed anyway, so the decoder reports the loss.
+ */
+static STMLIBS_StatusTypeDef _LOGGER_emit_or_drop(LOGGER_HandleTypeDef *handle,
+                                                  LOGGER_MODE mode,
+                                                  LOGGER_TimestampTypeDef timestamp,
+                                                  const char *text,
+                                                  uint32_t text_len) {
+    STMLIBS_StatusTypeDef errorcode = _LOGGER_emit(handle, mode, timestamp, text, text_len);
+
+    if (errorcode != STMLIBS_OK && handle->output == LOGGER_OUTPUT_FRAMED) {
+        CS_ENTER();
+        ++handle->sequence;
+        CS_EXIT();
+    }
+
+    return errorcode;
+}
+
+uint32_t LOGGER_format_u32(char *dst, uint32_t value, uint8_t width) {
+    char digits[10];
+    uint32_t n = 0;
+
+    // Division by a constant compiles to a multiplication, no library call
+    do {
+        digits[n++] = '0' + value % 10;
+        value /= 10;
+    } while (value != 0);
+
+    uint32_t len = 0;
+    while (len + n < width) {
+        dst[len++] = ' ';
+    }
+    while (n > 0) {
+        dst[len++] = digits[--n];
+    }
+
+    return len;
+}
+
+uint32_t LOGGER_format_i32(char *dst, int32_t value) {
+    if (value < 0) {
+        dst[0] = '-';
+        return 1 + LOGGER_format_u32(dst + 1, -(uint32_t)value, 0);
+    }
+
+    return LOGGER_format_u32(dst, (uint32_t)value, 0);
+}
+
+uint32_t LOGGER_format_hex(char *dst, uint32_t value, uint8_t digits) {
+    static const char hex[] = "0123456789abcdef";
+
+    if (digits == 0) {
+        for (uint32_t v = value; v != 0; v >>= 4) {
+            ++digits;
+        }
+    }
+    if (digits == 0) {
+        digits = 1;
+    }
+    if (digits > 8) {
+        digits = 8;
+    }
+
+    for (uint8_t i = 0; i < digits; ++i) {
+        dst[i] = hex[(value >> (4 * (digits - 1 - i))) & 0xF];
+    }
+
+    return digits;
+}
+
+uint32_t LOGGER_format_fixed(char *dst, int32_t value, uint8_t decimals) {
+    if (decimals == 0) {
+        return LOGGER_format_i32(dst, value);
+    }
+    if (decimals > 9) {
+        decimals = 9;
+    }
+
+    uint32_t len       = 0;
+    uint32_t magnitude = value < 0 ? -(uint32_t)value : (uint32_t)value;
+
+    if (value < 0) {
+        dst[len++] = '-';
+    }
+
+    len += LOGGER_format_u32(dst + len, magnitude / _LOGGER_pow10[decimals], 0);
+    dst[len++] = '.';
+
+    // Zero padded fractional part
+    uint32_t fraction = magnitude % _LOGGER_pow10[decimals];
+    for (uint8_t i = decimals; i > 0; --i) {
+        dst[len++] = '0' + (fraction / _LOGGER_pow10[i - 1]) % 10;
+    }
+
+    return len;
+}
+
 STMLIBS_StatusTypeDef LOGGER_init(LOGGER_HandleTypeDef *handle,
                                   char *buffer,
                                   uint32_t buffer_len,
@@ -45,69 +388,424 @@ STMLIBS_StatusTypeDef LOGGER_init(LOGGER_HandleTypeDef *handle,
         return STMLIBS_ERROR;
     }
 
-    handle->buffer     = buffer;
-    handle->buffer_len = buffer_len;
-    handle->index      = 0;
-    handle->flush_raw  = flush_raw;
+    handle->buffer       = buffer;
+    handle->buffer_len   = buffer_len;
+    handle->index        = 0;
+    handle->flush_raw    = flush_raw;
+    handle->threshold    = LOGGER_LEVEL_DEBUG;
+    handle->clock        = NULL;
+    handle->microseconds = 0;
+    handle->records      = NULL;
+    handle->lanes        = NULL;
+    handle->lanes_length = 0;
+    handle->output       = LOGGER_OUTPUT_TEXT;
+    handle->sequence     = 0;
+    handle->sites        = NULL;
+    handle->halves[0]    = NULL;
+    handle->halves[1]    = NULL;
+    handle->active       = 0;
+    handle->pending      = 0;
+    handle->flushing     = 0;
 
     return STMLIBS_OK;
 }
 
-STMLIBS_StatusTypeDef LOGGER_log(LOGGER_HandleTypeDef *handle, LOGGER_MODE mode, char *template, ...) {
+STMLIBS_StatusTypeDef LOGGER_init_async(LOGGER_HandleTypeDef *handle,
+                                        char *buffer,
+                                        uint32_t buffer_len,
+                                        LOGGER_flushTypeDef flush_raw) {
+    STMLIBS_StatusTypeDef errorcode = LOGGER_init(handle, buffer, buffer_len / 2, flush_raw);
+
+    if (errorcode != STMLIBS_OK) {
+        return errorcode;
+    }
+
+    handle->halves[0] = buffer;
+    handle->halves[1] = buffer + buffer_len / 2;
+
+    return STMLIBS_OK;
+}
+
+STMLIBS_StatusTypeDef LOGGER_init_deferred(LOGGER_HandleTypeDef *handle, CIRCULAR_BUFFER_MPSC_HandleTypeDef *records) {
     if (handle == NULL) {
         return STMLIBS_ERROR;
     }
 
-    if (template == NULL) {
+    // mask is 0 on a queue never initialized, CIRCULAR_BUFFER_MPSC_init rejects a single slot
+    if (records == NULL || records->size != sizeof(LOGGER_RecordTypeDef) || records->mask == 0) {
+        return STMLIBS_ERROR;
+    }
+
+    handle->records = records;
+
+    return STMLIBS_OK;
+}
+
+STMLIBS_StatusTypeDef LOGGER_init_lanes(LOGGER_HandleTypeDef *handle,
+                                        CIRCULAR_BUFFER_SPSC_HandleTypeDef *lanes,
+                                        uint8_t lanes_length) {
+    if (handle == NULL || lanes == NULL) {
         return STMLIBS_ERROR;
     }
 
-    if (handle->index >= handle->buffer_len - 1) {
+    for (uint8_t i = 0; i < lanes_length; ++i) {
+        if (lanes[i].size != sizeof(LOGGER_RecordTypeDef)) {
+            return STMLIBS_ERROR;
+        }
+    }
+
+    handle->lanes        = lanes;
+    handle->lanes_length = lanes_length;
+
+    return STMLIBS_OK;
+}
+
+STMLIBS_StatusTypeDef LOGGER_set_timestamp_source(LOGGER_HandleTypeDef *handle,
+                                                  LOGGER_clockTypeDef clock,
+                                                  uint8_t microseconds) {
+    if (handle == NULL) {
+        return STMLIBS_ERROR;
+    }
+
+    handle->clock        = clock;
+    handle->microseconds = clock != NULL && microseconds;
+
+    return STMLIBS_OK;
+}
+
+STMLIBS_StatusTypeDef LOGGER_set_output(LOGGER_HandleTypeDef *handle, LOGGER_OUTPUT output) {
+    if (handle == NULL) {
+        return STMLIBS_ERROR;
+    }
+
+    handle->output = output;
+
+    return STMLIBS_OK;
+}
+
+STMLIBS_StatusTypeDef LOGGER_set_threshold(LOGGER_HandleTypeDef *handle, uint8_t level) {
+    if (handle == NULL) {
+        return STMLIBS_ERROR;
+    }
+
+    handle->threshold = level;
+
+    return STMLIBS_OK;
+}
+
+STMLIBS_StatusTypeDef LOGGER_register_site(LOGGER_HandleTypeDef *handle, LOGGER_SiteTypeDef *site) {
+    if (handle == NULL || site == NULL) {
         return STMLIBS_ERROR;
     }
 
     CS_ENTER();
+    // Another priority may have registered it in the meantime
+    if (!site->registered) {
+        site->next       = handle->sites;
+        handle->sites    = site;
+        site->registered = 1;
+    }
+    CS_EXIT();
+
+    return STMLIBS_OK;
+}
 
-    char *s = NULL;
+LOGGER_SiteTypeDef *LOGGER_get_sites(LOGGER_HandleTypeDef *handle) {
+    if (handle == NULL) {
+        return NULL;
+    }
 
-    switch (mode) {
-        case LOGGER_INFO:
-            s = LOGGER_INFO_STRING;
-            break;
-        case LOGGER_DEBUG:
-            s = LOGGER_DEBUG_STRING;
-            break;
-        case LOGGER_WARNING:
-            s = LOGGER_WARNING_STRING;
-            break;
-        case LOGGER_ERROR:
-            s = LOGGER_ERROR_STRING;
-            break;
-        default:
-            return STMLIBS_ERROR;
+    return handle->sites;
+}
+
+STMLIBS_StatusTypeDef LOGGER_log(LOGGER_HandleTypeDef *handle, LOGGER_MODE mode, char *template, ...) {
+    if (handle == NULL) {
+        return STMLIBS_ERROR;
     }
 
-    if (mode != LOGGER_RAW) {
-        handle->buffer[handle->index++] = '\r';
-        handle->buffer[handle->index++] = '\n';
-        handle->index += snprintf(
-            handle->buffer + handle->index, handle->buffer_len - handle->index - 1, "%s[%5ld] ", s, HAL_GetTick());
+    if (template == NULL || mode > LOGGER_RAW) {
+        return STMLIBS_ERROR;
     }
 
+    if (_LOGGER_is_filtered(handle, mode)) {
+        return STMLIBS_OK;
+    }
+
+    LOGGER_TimestampTypeDef timestamp = _LOGGER_timestamp(handle);
     va_list args;
+
+    if (handle->output == LOGGER_OUTPUT_FRAMED) {
+        char line[LOGGER_DEFERRED_LINE_LEN];
+
+        va_start(args, template);
+        int len = vsnprintf(line, sizeof(line), template, args);
+        va_end(args);
+
+        if (len < 0) {
+            return STMLIBS_ERROR;
+        }
+
+        uint32_t line_len = (uint32_t)len < sizeof(line) ? (uint32_t)len : sizeof(line) - 1;
+        return _LOGGER_emit_or_drop(handle, mode, timestamp, line, line_len);
+    }
+
+    CS_ENTER();
+
+    if (handle->index + LOGGER_HEADER_MAX_LEN >= handle->buffer_len) {
+        CS_EXIT();
+        return STMLIBS_ERROR;
+    }
+
+    handle->index += _LOGGER_write_header(handle, handle->buffer + handle->index, mode, timestamp);
+
+    uint32_t room = handle->buffer_len - handle->index - 1;
+
     va_start(args, template);
-    handle->index += vsnprintf(handle->buffer + handle->index, handle->buffer_len - handle->index - 1, template, args);
+    int len = vsnprintf(handle->buffer + handle->index, room, template, args);
     va_end(args);
 
+    // On truncation vsnprintf returns the length the line would have had, not what it wrote
+    uint32_t written = len < 0 ? 0 : (uint32_t)len < room ? (uint32_t)len : room > 0 ? room - 1 : 0;
+    handle->index += written;
+
     CS_EXIT();
 
-    if (handle->index >= handle->buffer_len) {
+    if (len < 0 || written < (uint32_t)len) {
         return STMLIBS_ERROR;
     }
 
     return STMLIBS_OK;
 }
 
+/**
+ * @brief     printf-free line made of a label and a formatted value
+ */
+static STMLIBS_StatusTypeDef _LOGGER_log_formatted(LOGGER_HandleTypeDef *handle,
+                                                   LOGGER_MODE mode,
+                                                   const char *label,
+                                                   const char *value,
+                                                   uint32_t value_len) {
+    if (label == NULL) {
+        return STMLIBS_ERROR;
+    }
+
+    char line[LOGGER_DEFERRED_LINE_LEN];
+    uint32_t label_len = strlen(label);
+
+    if (label_len + value_len > sizeof(line)) {
+        return STMLIBS_ERROR;
+    }
+
+    memcpy(line, label, label_len);
+    memcpy(line + label_len, value, value_len);
+
+    return _LOGGER_emit_or_drop(handle, mode, _LOGGER_timestamp(handle), line, label_len + value_len);
+}
+
+STMLIBS_StatusTypeDef LOGGER_log_value(LOGGER_HandleTypeDef *handle,
+                                       LOGGER_MODE mode,
+                                       const char *label,
+                                       int32_t value,
+                                       uint8_t decimals) {
+    if (handle == NULL || mode > LOGGER_RAW) {
+        return STMLIBS_ERROR;
+    }
+
+    if (_LOGGER_is_filtered(handle, mode)) {
+        return STMLIBS_OK;
+    }
+
+    char value_str[LOGGER_FORMAT_MAX_LEN];
+    uint32_t value_len = LOGGER_format_fixed(value_str, value, decimals);
+
+    return _LOGGER_log_formatted(handle, mode, label, value_str, value_len);
+}
+
+STMLIBS_StatusTypeDef LOGGER_log_hex(LOGGER_HandleTypeDef *handle, LOGGER_MODE mode, const char *label, uint32_t value) {
+    if (handle == NULL || mode > LOGGER_RAW) {
+        return STMLIBS_ERROR;
+    }
+
+    if (_LOGGER_is_filtered(handle, mode)) {
+        return STMLIBS_OK;
+    }
+
+    char value_str[LOGGER_FORMAT_MAX_LEN] = {'0', 'x'};
+    uint32_t value_len                    = 2 + LOGGER_format_hex(value_str + 2, value, 8);
+
+    return _LOGGER_log_formatted(handle, mode, label, value_str, value_len);
+}
+
+static inline void _LOGGER_make_record(LOGGER_HandleTypeDef *handle,
+                                       LOGGER_RecordTypeDef *record,
+                                       LOGGER_MODE mode,
+                                       const char *template,
+                                       uint8_t args_length,
+                                       const LOGGER_WordTypeDef *args) {
+    record->template    = template;
+    record->timestamp   = _LOGGER_timestamp(handle);
+    record->mode        = mode;
+    record->args_length = args_length;
+    memcpy(record->args, args, args_length * sizeof(LOGGER_WordTypeDef));
+}
+
+STMLIBS_StatusTypeDef LOGGER_log_deferred(LOGGER_HandleTypeDef *handle,
+                                          LOGGER_MODE mode,
+                                          const char *template,
+                                          uint8_t args_length,
+                                          const LOGGER_WordTypeDef *args) {
+    if (handle == NULL || handle->records == NULL) {
+        return STMLIBS_ERROR;
+    }
+
+    if (template == NULL || mode > LOGGER_RAW || args_length > LOGGER_DEFERRED_MAX_ARGS) {
+        return STMLIBS_ERROR;
+    }
+
+    if (_LOGGER_is_filtered(handle, mode)) {
+        return STMLIBS_OK;
+    }
+
+    LOGGER_RecordTypeDef record;
+    _LOGGER_make_record(handle, &record, mode, template, args_length, args);
+
+    return CIRCULAR_BUFFER_MPSC_enqueue(handle->records, &record);
+}
+
+STMLIBS_StatusTypeDef LOGGER_log_lane(LOGGER_HandleTypeDef *handle,
+                                      uint8_t lane,
+                                      LOGGER_MODE mode,
+                                      const char *template,
+                                      uint8_t args_length,
+                                      const LOGGER_WordTypeDef *args) {
+    if (handle == NULL || lane >= handle->lanes_length) {
+        return STMLIBS_ERROR;
+    }
+
+    if (template == NULL || mode > LOGGER_RAW || args_length > LOGGER_DEFERRED_MAX_ARGS) {
+        return STMLIBS_ERROR;
+    }
+
+    if (_LOGGER_is_filtered(handle, mode)) {
+        return STMLIBS_OK;
+    }
+
+    // The record is built on the stack, a preempting lane never sees it half written
+    LOGGER_RecordTypeDef record;
+    _LOGGER_make_record(handle, &record, mode, template, args_length, args);
+
+    return CIRCULAR_BUFFER_SPSC_enqueue(&handle->lanes[lane], &record);
+}
+
+static uint32_t _LOGGER_format_record(LOGGER_RecordTypeDef *record, char *line, uint32_t line_len) {
+    // Each specifier consumes exactly one word, the unused trailing ones are ignored
+    LOGGER_WordTypeDef a[8] = {0};
+    memcpy(a, record->args, record->args_length * sizeof(LOGGER_WordTypeDef));
+
+    int written = snprintf(line, line_len, record->template, a[0], a[1], a[2], a[3], a[4], a[5], a[6], a[7]);
+
+    if (written < 0) {
+        return 0;
+    }
+
+    return (uint32_t)written < line_len ? (uint32_t)written : line_len - 1;
+}
+
+/**
+ * @brief     Oldest pending record among the shared queue and the lanes
+ * @param     lane Set to the index of the lane holding it, lanes_length for the shared queue
+ * @return    the record in place, NULL if nothing is pending
+ */
+static LOGGER_RecordTypeDef *_LOGGER_next_record(LOGGER_HandleTypeDef *handle, uint8_t *lane) {
+    LOGGER_RecordTypeDef *oldest = NULL;
+
+    if (handle->records != NULL) {
+        oldest = CIRCULAR_BUFFER_MPSC_peek(handle->records);
+        *lane  = handle->lanes_length;
+    }
+
+    for (uint8_t i = 0; i < handle->lanes_length; ++i) {
+        void *span;
+        if (CIRCULAR_BUFFER_SPSC_peek(&handle->lanes[i], &span) == 0) {
+            continue;
+        }
+
+        // Wrap-safe comparison, timestamps are free running
+        LOGGER_RecordTypeDef *record = span;
+        if (oldest == NULL || (int32_t)(record->timestamp - oldest->timestamp) < 0) {
+            oldest = record;
+            *lane  = i;
+        }
+    }
+
+    return oldest;
+}
+
+static void _LOGGER_drain_records(LOGGER_HandleTypeDef *handle) {
+    LOGGER_RecordTypeDef *record;
+    uint8_t lane;
+    char line[LOGGER_DEFERRED_LINE_LEN];
+
+    while ((record = _LOGGER_next_record(handle, &lane)) != NULL) {
+        // Format outside of the critical section, only the copy has to be atomic with LOGGER_log
+        uint32_t len = _LOGGER_format_record(record, line, sizeof(line));
+
+        // A line not fitting with its header or framing is kept for the next flush,
+        // unless the buffer is empty: then it would never fit and it is dropped
+        if (handle->index == 0) {
+            _LOGGER_emit_or_drop(handle, record->mode, record->timestamp, line, len);
+        } else if (_LOGGER_emit(handle, record->mode, record->timestamp, line, len) != STMLIBS_OK) {
+            break;
+        }
+
+        if (lane == handle->lanes_length) {
+            CIRCULAR_BUFFER_MPSC_release(handle->records);
+        } else {
+            CIRCULAR_BUFFER_SPSC_release(&handle->lanes[lane], 1);
+        }
+    }
+}
+
+static STMLIBS_StatusTypeDef _LOGGER_flush_async(LOGGER_HandleTypeDef *handle) {
+    if (handle->flushing) {
+        return STMLIBS_BUSY;
+    }
+
+    // A previously failed flush_raw is retried before swapping again
+    if (handle->pending == 0) {
+        if (handle->index == 0) {
+            return STMLIBS_OK;
+        }
+
+        CS_ENTER();
+        handle->pending = handle->index;
+        handle->active ^= 1;
+        handle->buffer = handle->halves[handle->active];
+        handle->index  = 0;
+        CS_EXIT();
+    }
+
+    STMLIBS_StatusTypeDef errorcode = STMLIBS_OK;
+
+    handle->flushing = 1;
+    if ((errorcode = handle->flush_raw(handle->halves[handle->active ^ 1], handle->pending)) != STMLIBS_OK) {
+        handle->flushing = 0;
+    }
+
+    return errorcode;
+}
+
+STMLIBS_StatusTypeDef LOGGER_flush_complete(LOGGER_HandleTypeDef *handle) {
+    if (handle == NULL) {
+        return STMLIBS_ERROR;
+    }
+
+    handle->pending  = 0;
+    handle->flushing = 0;
+
+    return STMLIBS_OK;
+}
+
 STMLIBS_StatusTypeDef LOGGER_flush(LOGGER_HandleTypeDef *handle) {
     if (handle == NULL) {
         return STMLIBS_ERROR;
@@ -115,6 +813,14 @@ STMLIBS_StatusTypeDef LOGGER_flush(LOGGER_HandleTypeDef *handle) {
 
     static STMLIBS_StatusTypeDef errorcode = STMLIBS_OK;
 
+    if (handle->records != NULL || handle->lanes_length > 0) {
+        _LOGGER_drain_records(handle);
+    }
+
+    if (handle->halves[0] != NULL) {
+        return _LOGGER_flush_async(handle);
+    }
+
     if (handle->index == 0) {
         return STMLIBS_OK;
     }
@@ -11,18 +11,119 @@
 #ifndef LOGGER_H
 #define LOGGER_H
 
+#include "circular_buffer_mpsc.h"
+#include "circular_buffer_spsc.h"
 #include "main.h"
 #include "stmlibs_status.h"
 
+#include <stdint.h>
+
+/** @brief Maximum number of arguments stored by a deferred log record */
+#ifndef LOGGER_DEFERRED_MAX_ARGS
+#define LOGGER_DEFERRED_MAX_ARGS 4
+#endif  //LOGGER_DEFERRED_MAX_ARGS
+
+#if LOGGER_DEFERRED_MAX_ARGS > 8
+#error "LOGGER_DEFERRED_MAX_ARGS must not exceed 8"
+#endif
+
+/** @brief Maximum length of a deferred record once formatted by LOGGER_flush, and of the text of a frame */
+#ifndef LOGGER_DEFERRED_LINE_LEN
+#define LOGGER_DEFERRED_LINE_LEN 128
+#endif  //LOGGER_DEFERRED_LINE_LEN
+
 typedef enum { LOGGER_INFO, LOGGER_DEBUG, LOGGER_WARNING, LOGGER_ERROR, LOGGER_RAW } LOGGER_MODE;
 
+typedef enum {
+    /** @brief ANSI colored text lines */
+    LOGGER_OUTPUT_TEXT,
+    /**
+     * @brief COBS encoded frames terminated by 0x00, decoded on the host by logdec.
+     *        Before encoding a frame is: mode (u8), sequence number (u16),
+     *        timestamp (u32), flags (u8, bit 0 set for microseconds), text,
+     *        CRC-16/CCITT-FALSE of all the previous bytes (u16), little endian.
+     */
+    LOGGER_OUTPUT_FRAMED
+} LOGGER_OUTPUT;
+
+/* Severity levels, in increasing order, used by the filters. LOGGER_RAW is never filtered. */
+#define LOGGER_LEVEL_DEBUG   0U
+#define LOGGER_LEVEL_INFO    1U
+#define LOGGER_LEVEL_WARNING 2U
+#define LOGGER_LEVEL_ERROR   3U
+#define LOGGER_LEVEL_NONE    4U
+
+/** @brief Lowest level compiled in by the LOGGER_DBG/INF/WRN/ERR front-ends */
+#ifndef LOGGER_COMPILE_LEVEL
+#define LOGGER_COMPILE_LEVEL LOGGER_LEVEL_DEBUG
+#endif  //LOGGER_COMPILE_LEVEL
+
 typedef STMLIBS_StatusTypeDef (*LOGGER_flushTypeDef)(char *buffer, uint32_t size);
 
+/** @brief Characters written at most by a LOGGER_format_* function */
+#define LOGGER_FORMAT_MAX_LEN 12
+
+/**
+ * @brief Milliseconds from HAL_GetTick, or the value of the clock set by
+ *        LOGGER_set_timestamp_source (e.g. the lower 32 bits of a 1us
+ *        LONGCOUNTER, wrapping every ~71 minutes)
+ */
+typedef uint32_t LOGGER_TimestampTypeDef;
+
+typedef LOGGER_TimestampTypeDef (*LOGGER_clockTypeDef)(void);
+
+/** @brief Deferred log arguments are stored as raw machine words */
+typedef uintptr_t LOGGER_WordTypeDef;
+
+struct LOGGER_RecordStruct {
+    const char *template;
+    LOGGER_TimestampTypeDef timestamp;
+    uint8_t mode;
+    uint8_t args_length;
+    LOGGER_WordTypeDef args[LOGGER_DEFERRED_MAX_ARGS];
+};
+typedef struct LOGGER_RecordStruct LOGGER_RecordTypeDef;
+
+/**
+ * @brief Per call site state of the rate limited front-ends, statically
+ *        allocated by LOGGER_LIMIT and linked into the handle on first use
+ */
+struct LOGGER_SiteStruct {
+    const char *file;
+    uint16_t line;
+    uint8_t registered;
+    /** @brief HAL_GetTick of the last message let through */
+    uint32_t last;
+    /** @brief Messages suppressed and not reported by a summary line yet */
+    uint32_t suppressed;
+    /** @brief Messages suppressed since boot */
+    uint32_t total_suppressed;
+    struct LOGGER_SiteStruct *next;
+};
+typedef struct LOGGER_SiteStruct LOGGER_SiteTypeDef;
+
 struct LOGGER_HandleStruct {
     char *buffer;
     uint32_t buffer_len;
     uint32_t index;
     LOGGER_flushTypeDef flush_raw;
+    uint8_t threshold;
+    LOGGER_clockTypeDef clock;
+    uint8_t microseconds;
+
+    CIRCULAR_BUFFER_MPSC_HandleTypeDef *records;
+    CIRCULAR_BUFFER_SPSC_HandleTypeDef *lanes;
+    uint8_t lanes_length;
+
+    uint8_t output;
+    uint16_t sequence;
+
+    LOGGER_SiteTypeDef *sites;
+
+    char *halves[2];
+    uint8_t active;
+    uint32_t pending;
+    volatile uint8_t flushing;
 };
 typedef struct LOGGER_HandleStruct LOGGER_HandleTypeDef;
 
@@ -32,5 +133,407 @@ STMLIBS_StatusTypeDef LOGGER_init(LOGGER_HandleTypeDef *handle,
                                   LOGGER_flushTypeDef flush_raw);
 STMLIBS_StatusTypeDef LOGGER_log(LOGGER_HandleTypeDef *handle, LOGGER_MODE mode, char *template, ...);
 STMLIBS_StatusTypeDef LOGGER_flush(LOGGER_HandleTypeDef *handle);
+/**
+ * @brief     Select the output format, LOGGER_OUTPUT_TEXT by default
+ *
+ * @param     handle Reference to the handle
+ * @param     output Output format
+ * @return    STMLIBS_OK on success, STMLIBS_ERROR on failure
+ */
+STMLIBS_StatusTypeDef LOGGER_set_output(LOGGER_HandleTypeDef *handle, LOGGER_OUTPUT output);
+/**
+ * @brief     Set the runtime threshold: messages below level are discarded
+ *                before any formatting or interrupt masking
+ *
+ * @param     handle Reference to the handle
+ * @param     level One of LOGGER_LEVEL_*, LOGGER_LEVEL_DEBUG by default
+ * @return    STMLIBS_OK on success, STMLIBS_ERROR on failure
+ */
+STMLIBS_StatusTypeDef LOGGER_set_threshold(LOGGER_HandleTypeDef *handle, uint8_t level);
+/**
+ * @brief     Take the timestamps from clock instead of HAL_GetTick, e.g. a
+ *                function returning LONGCOUNTER_get_counter of a 1us counter
+ *                to get microsecond resolution inside a control period
+ *
+ * @param     handle Reference to the handle
+ * @param     clock Function returning the timestamp, NULL to go back to HAL_GetTick
+ * @param     microseconds 1 if clock counts microseconds, 0 for milliseconds
+ * @return    STMLIBS_OK on success, STMLIBS_ERROR on failure
+ */
+STMLIBS_StatusTypeDef LOGGER_set_timestamp_source(LOGGER_HandleTypeDef *handle,
+                                                  LOGGER_clockTypeDef clock,
+                                                  uint8_t microseconds);
+
+/**
+ * @brief     Log "<label><value>" without the printf engine, value is printed
+ *                as a fixed point number: LOGGER_log_value(h, LOGGER_INFO, "vbat ", 12345, 3)
+ *                prints "vbat 12.345"
+ *
+ * @param     handle Reference to the handle
+ * @param     mode Log level
+ * @param     label Text preceding the value
+ * @param     value Value scaled by 10^decimals
+ * @param     decimals Number of fractional digits, 0 for a plain integer
+ * @return    STMLIBS_OK on success, STMLIBS_ERROR on failure
+ */
+STMLIBS_StatusTypeDef LOGGER_log_value(LOGGER_HandleTypeDef *handle,
+                                       LOGGER_MODE mode,
+                                       const char *label,
+                                       int32_t value,
+                                       uint8_t decimals);
+/**
+ * @brief     Log "<label>0x<value>" with 8 hex digits without the printf engine
+ *
+ * @param     handle Reference to the handle
+ * @param     mode Log level
+ * @param     label Text preceding the value
+ * @param     value Value to be printed
+ * @return    STMLIBS_OK on success, STMLIBS_ERROR on failure
+ */
+STMLIBS_StatusTypeDef LOGGER_log_hex(LOGGER_HandleTypeDef *handle, LOGGER_MODE mode, const char *label, uint32_t value);
+
+/**
+ * @brief     Write value in decimal, right aligned on width characters
+ * @return    number of characters written
+ */
+uint32_t LOGGER_format_u32(char *dst, uint32_t value, uint8_t width);
+/**
+ * @brief     Write value in decimal
+ * @return    number of characters written
+ */
+uint32_t LOGGER_format_i32(char *dst, int32_t value);
+/**
+ * @brief     Write value in lowercase hex on digits characters, 0 for the minimum needed
+ * @return    number of characters written
+ */
+uint32_t LOGGER_format_hex(char *dst, uint32_t value, uint8_t digits);
+/**
+ * @brief     Write value / 10^decimals with exactly decimals fractional digits
+ * @return    number of characters written
+ */
+uint32_t LOGGER_format_fixed(char *dst, int32_t value, uint8_t decimals);
+
+/**
+ * @brief     Initialize a LOGGER_HandleTypeDef structure in double buffered
+ *                mode: the buffer is split in two halves, LOGGER_flush hands
+ *                the filled half to flush_raw (e.g. a DMA transfer) while
+ *                logging continues into the other one
+ *
+ * @param     handle Reference to the struct to be initialized
+ * @param     buffer Storage for both halves
+ * @param     buffer_len Total length of buffer
+ * @param     flush_raw Function starting the transmission, may return before it completes
+ * @return    STMLIBS_OK on success, STMLIBS_ERROR on failure
+ */
+STMLIBS_StatusTypeDef LOGGER_init_async(LOGGER_HandleTypeDef *handle,
+                                        char *buffer,
+                                        uint32_t buffer_len,
+                                        LOGGER_flushTypeDef flush_raw);
+/**
+ * @brief     Give back the half passed to flush_raw, to be called when the
+ *                transmission completes (e.g. in HAL_UART_TxCpltCallback).
+ *                Until then LOGGER_flush returns STMLIBS_BUSY.
+ *
+ * @param     handle Reference to the handle
+ * @return    STMLIBS_OK on success, STMLIBS_ERROR on failure
+ */
+STMLIBS_StatusTypeDef LOGGER_flush_complete(LOGGER_HandleTypeDef *handle);
+
+/**
+ * @brief     Enable deferred logging on an initialized handle
+ *
+ * @param     handle Reference to the handle
+ * @param     records Queue initialized with elements of sizeof(LOGGER_RecordTypeDef), at least 2
+ * @return    STMLIBS_OK on success, STMLIBS_ERROR on failure
+ */
+STMLIBS_StatusTypeDef LOGGER_init_deferred(LOGGER_HandleTypeDef *handle, CIRCULAR_BUFFER_MPSC_HandleTypeDef *records);
+/**
+ * @brief     Store a log record without formatting it, safe from any interrupt
+ *                priority and without masking interrupts. The record is
+ *                formatted by LOGGER_flush. Use it through LOGGER_DEFER.
+ *
+ * @param     handle Reference to the handle
+ * @param     mode Log level
+ * @param     template Format string, must outlive the record (e.g. a string literal)
+ * @param     args_length Number of arguments
+ * @param     args Arguments, each one consumed by a single word sized conversion
+ * @return    STMLIBS_OK on success, STMLIBS_ERROR if the record queue is full
+ */
+STMLIBS_StatusTypeDef LOGGER_log_deferred(LOGGER_HandleTypeDef *handle,
+                                          LOGGER_MODE mode,
+                                          const char *template,
+                                          uint8_t args_length,
+                                          const LOGGER_WordTypeDef *args);
+
+/**
+ * @brief     Enable per-producer lanes on an initialized handle: every lane is
+ *                written by a single interrupt priority (or the main loop) so
+ *                producers never share a record. LOGGER_flush merges the lanes,
+ *                and the LOGGER_init_deferred queue if any, by timestamp.
+ *
+ * @param     handle Reference to the handle
+ * @param     lanes Array of queues initialized with elements of sizeof(LOGGER_RecordTypeDef)
+ * @param     lanes_length Number of lanes
+ * @return    STMLIBS_OK on success, STMLIBS_ERROR on failure
+ */
+STMLIBS_StatusTypeDef LOGGER_init_lanes(LOGGER_HandleTypeDef *handle,
+                                        CIRCULAR_BUFFER_SPSC_HandleTypeDef *lanes,
+                                        uint8_t lanes_length);
+/**
+ * @brief     Same as LOGGER_log_deferred, storing the record in the given lane.
+ *                Use it through LOGGER_DEFER_LANE.
+ *
+ * @param     handle Reference to the handle
+ * @param     lane Index of the lane owned by the calling priority
+ * @param     mode Log level
+ * @param     template Format string, must outlive the record (e.g. a string literal)
+ * @param     args_length Number of arguments
+ * @param     args Arguments, each one consumed by a single word sized conversion
+ * @return    STMLIBS_OK on success, STMLIBS_ERROR if the lane is full
+ */
+STMLIBS_StatusTypeDef LOGGER_log_lane(LOGGER_HandleTypeDef *handle,
+                                      uint8_t lane,
+                                      LOGGER_MODE mode,
+                                      const char *template,
+                                      uint8_t args_length,
+                                      const LOGGER_WordTypeDef *args);
+
+/**
+ * @brief     Link a call site into the handle, done once by LOGGER_site_allow
+ *
+ * @param     handle Reference to the handle
+ * @param     site Statically allocated call site state
+ * @return    STMLIBS_OK on success, STMLIBS_ERROR on failure
+ */
+STMLIBS_StatusTypeDef LOGGER_register_site(LOGGER_HandleTypeDef *handle, LOGGER_SiteTypeDef *site);
+/**
+ * @brief     Call sites used so far through LOGGER_LIMIT and LOGGER_DEFER_LIMIT,
+ *                follow site->next to walk the list, e.g. to find noisy sites
+ *                by their total_suppressed counter
+ *
+ * @param     handle Reference to the handle
+ * @return    most recently registered site, NULL if none
+ */
+LOGGER_SiteTypeDef *LOGGER_get_sites(LOGGER_HandleTypeDef *handle);
+
+/**
+ * @brief     Level of mode compared with the runtime threshold, LOGGER_LEVEL_NONE
+ *                for LOGGER_RAW which is never filtered
+ */
+static inline uint8_t LOGGER_level_of(LOGGER_MODE mode) {
+    switch (mode) {
+        case LOGGER_DEBUG:
+            return LOGGER_LEVEL_DEBUG;
+        case LOGGER_INFO:
+            return LOGGER_LEVEL_INFO;
+        case LOGGER_WARNING:
+            return LOGGER_LEVEL_WARNING;
+        case LOGGER_ERROR:
+            return LOGGER_LEVEL_ERROR;
+        default:
+            return LOGGER_LEVEL_NONE;
+    }
+}
+
+/**
+ * @brief     Rate limit check, a tick read and a compare on the suppressed path.
+ *                Counters are not atomic: a site reached from several interrupt
+ *                priorities may miss a count.
+ *
+ * @param     handle Reference to the handle
+ * @param     site Statically allocated call site state
+ * @param     interval Minimum time between two messages in milliseconds
+ * @return    1 if the message has to be logged, 0 if it is suppressed
+ */
+static inline uint8_t LOGGER_site_allow(LOGGER_HandleTypeDef *handle, LOGGER_SiteTypeDef *site, uint32_t interval) {
+    uint32_t now = HAL_GetTick();
+
+    if (site->registered && now - site->last < interval) {
+        ++site->suppressed;
+        ++site->total_suppressed;
+        return 0;
+    }
+
+    if (!site->registered) {
+        LOGGER_register_site(handle, site);
+    }
+    site->last = now;
+
+    return 1;
+}
+
+/* Deferred logging front-end ------------------------------------------------*/
+
+#define _LOGGER_NARGS_(_0, _1, _2, _3, _4, _5, _6, _7, _8, N, ...) N
+#define _LOGGER_NARGS(...) \
+    _LOGGER_NARGS_(0, ##__VA_ARGS__, 8, 7, 6, 5, 4, 3, 2, 1, 0)
+
+/*
+ * Integer and pointer arguments fitting a word only: a floating point argument, or
+ * a 64 bit integer on a 32 bit target, fails to compile with a negative array size.
+ * (A) + 0 makes an array argument decay to the pointer that gets stored.
+ */
+#define _LOGGER_WORD_FITS(A) \
+    (_Generic((A), float: 0, double: 0, long double: 0, default: 1) && sizeof((A) + 0) <= sizeof(LOGGER_WordTypeDef))
+#define _LOGGER_WORD(A) ((LOGGER_WordTypeDef)(A) + 0 * sizeof(char[_LOGGER_WORD_FITS(A) ? 1 : -1]))
+
+#define _LOGGER_WORDS_0()
+#define _LOGGER_WORDS_1(A)                      _LOGGER_WORD(A)
+#define _LOGGER_WORDS_2(A, B)                   _LOGGER_WORDS_1(A), _LOGGER_WORD(B)
+#define _LOGGER_WORDS_3(A, B, C)                _LOGGER_WORDS_2(A, B), _LOGGER_WORD(C)
+#define _LOGGER_WORDS_4(A, B, C, D)             _LOGGER_WORDS_3(A, B, C), _LOGGER_WORD(D)
+#define _LOGGER_WORDS_5(A, B, C, D, E)          _LOGGER_WORDS_4(A, B, C, D), _LOGGER_WORD(E)
+#define _LOGGER_WORDS_6(A, B, C, D, E, F)       _LOGGER_WORDS_5(A, B, C, D, E), _LOGGER_WORD(F)
+#define _LOGGER_WORDS_7(A, B, C, D, E, F, G)    _LOGGER_WORDS_6(A, B, C, D, E, F), _LOGGER_WORD(G)
+#define _LOGGER_WORDS_8(A, B, C, D, E, F, G, H) _LOGGER_WORDS_7(A, B, C, D, E, F, G), _LOGGER_WORD(H)
+#define _LOGGER_WORDS_N(N, ...)                 _LOGGER_WORDS_##N(__VA_ARGS__)
+#define _LOGGER_WORDS_(N, ...)                  _LOGGER_WORDS_N(N, __VA_ARGS__)
+#define _LOGGER_WORDS(...)                      _LOGGER_WORDS_(_LOGGER_NARGS(__VA_ARGS__), __VA_ARGS__)
+
+/* Never called, only lets the compiler check the arguments against the template */
+__attribute__((format(printf, 1, 2))) static inline void _LOGGER_check_format(const char *template, ...) {
+    (void)template;
+}
+
+#define _LOGGER_CHECK_ARGS(template, ...)                                                             \
+    _Static_assert(_LOGGER_NARGS(__VA_ARGS__) <= LOGGER_DEFERRED_MAX_ARGS, "too many log arguments"); \
+    if (0) {                                                                                          \
+        _LOGGER_check_format(template, ##__VA_ARGS__);                                                \
+    }
+
+/**
+ * @brief     Deferred counterpart of LOGGER_log: only the template pointer, a
+ *                timestamp and the arguments are stored. The argument count
+ *                and types are checked at compile time against the template.
+ *
+ *                LOGGER_DEFER(&hlog, LOGGER_INFO, "adc %lu over %lu", value, threshold);
+ */
+#define LOGGER_DEFER(handle, mode, template, ...)                                                        \
+    do {                                                                                                 \
+        _LOGGER_CHECK_ARGS(template, ##__VA_ARGS__)                                                      \
+        const LOGGER_WordTypeDef _logger_args[] = {0, _LOGGER_WORDS(__VA_ARGS__)};                       \
+        LOGGER_log_deferred((handle), (mode), (template), _LOGGER_NARGS(__VA_ARGS__), _logger_args + 1); \
+    } while (0)
+
+/**
+ * @brief     LOGGER_DEFER on the lane owned by the calling priority
+ *
+ *                LOGGER_DEFER_LANE(&hlog, LANE_CAN_ISR, LOGGER_WARNING, "rx overrun %lu", count);
+ */
+#define LOGGER_DEFER_LANE(handle, lane, mode, template, ...)                                                 \
+    do {                                                                                                     \
+        _LOGGER_CHECK_ARGS(template, ##__VA_ARGS__)                                                          \
+        const LOGGER_WordTypeDef _logger_args[] = {0, _LOGGER_WORDS(__VA_ARGS__)};                           \
+        LOGGER_log_lane((handle), (lane), (mode), (template), _LOGGER_NARGS(__VA_ARGS__), _logger_args + 1); \
+    } while (0)
+
+/* Rate limited front-ends ----------------------------------------------------*/
+
+/*
+ * handle and mode are evaluated once, summary and call refer to them as _logger_handle and
+ * _logger_mode. A NULL handle discards the message, one filtered by the threshold is not
+ * counted as suppressed. summary is an expression returning STMLIBS_OK once the "N messages
+ * suppressed" line is stored, the count restarts only then. LOGGER_RAW sites print no
+ * summary: raw output may be parsed by a machine, their count is only kept in total_suppressed.
+ */
+#define _LOGGER_LIMITED(handle, mode, interval, summary, call)                                             \
+    do {                                                                                                   \
+        static LOGGER_SiteTypeDef _logger_site     = {.file = __FILE__, .line = __LINE__};                 \
+        LOGGER_HandleTypeDef *const _logger_handle = (handle);                                             \
+        const LOGGER_MODE _logger_mode             = (mode);                                               \
+        if (_logger_handle != NULL && LOGGER_level_of(_logger_mode) >= _logger_handle->threshold &&        \
+            LOGGER_site_allow(_logger_handle, &_logger_site, (interval))) {                                \
+            if (_logger_site.suppressed != 0 && (_logger_mode == LOGGER_RAW || (summary) == STMLIBS_OK)) { \
+                _logger_site.suppressed = 0;                                                               \
+            }                                                                                              \
+            call;                                                                                          \
+        }                                                                                                  \
+    } while (0)
+
+/**
+ * @brief     LOGGER_log letting through at most one message every interval
+ *                milliseconds from this call site. Suppressed messages are
+ *                neither formatted nor written to the buffer, the next
+ *                message let through is preceded by "N messages suppressed".
+ *
+ *                LOGGER_LIMIT(&hlog, LOGGER_ERROR, 1000, "can bus off %d", count);
+ */
+#define LOGGER_LIMIT(handle, mode, interval, ...)                                                          \
+    _LOGGER_LIMITED(handle,                                                                                \
+                    mode,                                                                                  \
+                    interval,                                                                              \
+                    LOGGER_log(_logger_handle,                                                             \
+                               _logger_mode,                                                               \
+                               "%lu messages suppressed",                                                  \
+                               (unsigned long)_logger_site.suppressed),                                    \
+                    LOGGER_log(_logger_handle, _logger_mode, __VA_ARGS__))
+
+/**
+ * @brief     Rate limited LOGGER_DEFER, see LOGGER_LIMIT
+ */
+#define LOGGER_DEFER_LIMIT(handle, mode, interval, ...)                                                    \
+    _LOGGER_LIMITED(handle,                                                                                \
+                    mode,                                                                                  \
+                    interval,                                                                              \
+                    LOGGER_log_deferred(_logger_handle,                                                    \
+                                        _logger_mode,                                                      \
+                                        "%u messages suppressed",                                          \
+                                        1,                                                                 \
+                                        (const LOGGER_WordTypeDef[]){_logger_site.suppressed}),            \
+                    LOGGER_DEFER(_logger_handle, _logger_mode, __VA_ARGS__))
+
+/* Level front-ends -----------------------------------------------------------*/
+
+/*
+ * Arguments are evaluated only when the level passes both the compile time and the runtime threshold.
+ * handle is evaluated once, call refers to it as _logger_handle. A NULL handle discards the message.
+ */
+#define _LOGGER_FILTERED(handle, level, call)                                  \
+    do {                                                                       \
+        LOGGER_HandleTypeDef *const _logger_handle = (handle);                 \
+        if (_logger_handle != NULL && (level) >= _logger_handle->threshold) { \
+            call;                                                              \
+        }                                                                      \
+    } while (0)
+
+#if LOGGER_COMPILE_LEVEL <= LOGGER_LEVEL_DEBUG
+#define LOGGER_DBG(handle, ...) \
+    _LOGGER_FILTERED(handle, LOGGER_LEVEL_DEBUG, LOGGER_log(_logger_handle, LOGGER_DEBUG, __VA_ARGS__))
+#define LOGGER_DEFER_DBG(handle, ...) \
+    _LOGGER_FILTERED(handle, LOGGER_LEVEL_DEBUG, LOGGER_DEFER(_logger_handle, LOGGER_DEBUG, __VA_ARGS__))
+#else
+#define LOGGER_DBG(handle, ...)       do { } while (0)
+#define LOGGER_DEFER_DBG(handle, ...) do { } while (0)
+#endif
+
+#if LOGGER_COMPILE_LEVEL <= LOGGER_LEVEL_INFO
+#define LOGGER_INF(handle, ...) \
+    _LOGGER_FILTERED(handle, LOGGER_LEVEL_INFO, LOGGER_log(_logger_handle, LOGGER_INFO, __VA_ARGS__))
+#define LOGGER_DEFER_INF(handle, ...) \
+    _LOGGER_FILTERED(handle, LOGGER_LEVEL_INFO, LOGGER_DEFER(_logger_handle, LOGGER_INFO, __VA_ARGS__))
+#else
+#define LOGGER_INF(handle, ...)       do { } while (0)
+#define LOGGER_DEFER_INF(handle, ...) do { } while (0)
+#endif
+
+#if LOGGER_COMPILE_LEVEL <= LOGGER_LEVEL_WARNING
+#define LOGGER_WRN(handle, ...) \
+    _LOGGER_FILTERED(handle, LOGGER_LEVEL_WARNING, LOGGER_log(_logger_handle, LOGGER_WARNING, __VA_ARGS__))
+#define LOGGER_DEFER_WRN(handle, ...) \
+    _LOGGER_FILTERED(handle, LOGGER_LEVEL_WARNING, LOGGER_DEFER(_logger_handle, LOGGER_WARNING, __VA_ARGS__))
+#else
+#define LOGGER_WRN(handle, ...)       do { } while (0)
+#define LOGGER_DEFER_WRN(handle, ...) do { } while (0)
+#endif
+
+#if LOGGER_COMPILE_LEVEL <= LOGGER_LEVEL_ERROR
+#define LOGGER_ERR(handle, ...) \
+    _LOGGER_FILTERED(handle, LOGGER_LEVEL_ERROR, LOGGER_log(_logger_handle, LOGGER_ERROR, __VA_ARGS__))
+#define LOGGER_DEFER_ERR(handle, ...) \
+    _LOGGER_FILTERED(handle, LOGGER_LEVEL_ERROR, LOGGER_DEFER(_logger_handle, LOGGER_ERROR, __VA_ARGS__))
+#else
+#define LOGGER_ERR(handle, ...)       do { } while (0)
+#define LOGGER_DEFER_ERR(handle, ...) do { } while (0)
+#endif
 
-#endif  //LOGGER_H
\ No newline at end of file
+#endif  //LOGGER_H
@@ -0,0 +1,90 @@
+/*
+ * "THE BEER-WARE LICENSE" (Revision 69):
+ * Squadra Corse firmware team wrote this file. As long as you retain this notice
+ * you can do whatever you want with this stuff. If we meet some day, and you
+ * think this stuff is worth it, you can buy us a beer in return.
+ *
+ * Authors
+ * - Federico Carbone [federico.carbone.sc@gmail.com]
+ */
+
+/*
+ * Size and cycles of three debug messages and one (never taken) error in a
+ * release build where debug output is unwanted:
+ *  - LOGGER_log, the message is discarded inside the function after the
+ *    arguments were evaluated
+ *  - LOGGER_DBG with the runtime threshold above debug
+ *  - LOGGER_DBG compiled out by LOGGER_COMPILE_LEVEL
+ * Every function lives in its own section, its size is the section size.
+ */
+
+#include "level_bench.h"
+#include "host.h"
+
+#define ITERATIONS 10000000U
+
+/* Sections named as C identifiers get __start_ and __stop_ symbols from the linker */
+#define SECTION_SIZE(name)                                      \
+    ({                                                          \
+        extern const uint8_t __start_##name[], __stop_##name[]; \
+        (uint32_t)(__stop_##name - __start_##name);             \
+    })
+
+static char buffer[4096];
+static LOGGER_HandleTypeDef hlog;
+static volatile uint32_t sink;
+
+__attribute__((noinline)) uint32_t level_bench_value(uint32_t i) {
+    sink = i;
+    return i * 2654435761U;
+}
+
+static STMLIBS_StatusTypeDef flush(char *data, uint32_t size) {
+    (void)data;
+    (void)size;
+    return STMLIBS_OK;
+}
+
+__attribute__((noinline, section("text_log"))) static void level_bench_log(LOGGER_HandleTypeDef *handle, uint32_t i) {
+    LOGGER_log(handle, LOGGER_DEBUG, "sample %lu", (unsigned long)level_bench_value(i));
+    LOGGER_log(handle, LOGGER_DEBUG, "state %lu", (unsigned long)level_bench_value(i + 1));
+    LOGGER_log(handle, LOGGER_DEBUG, "timer %lu", (unsigned long)level_bench_value(i + 2));
+    if (level_bench_value(i) == 0xFFFFFFFFU) {
+        LOGGER_log(handle, LOGGER_ERROR, "overflow at %lu", (unsigned long)i);
+    }
+}
+
+__attribute__((noinline, section("text_all"))) static void level_bench_all(LOGGER_HandleTypeDef *handle, uint32_t i) {
+    LEVEL_BENCH_BODY(handle, i);
+}
+
+static void report(const char *name, uint32_t bytes, void (*body)(LOGGER_HandleTypeDef *, uint32_t)) {
+    uint64_t start = host_cycles();
+
+    for (uint32_t i = 0; i < ITERATIONS; ++i) {
+        body(&hlog, i);
+    }
+
+    printf("%-34s %5" PRIu32 " %8.1f\n", name, bytes, (double)(host_cycles() - start) / ITERATIONS);
+}
+
+int main(void) {
+    HOST_CHECK(LOGGER_init(&hlog, buffer, sizeof(buffer), flush) == STMLIBS_OK);
+    HOST_CHECK(LOGGER_set_threshold(&hlog, LOGGER_LEVEL_INFO) == STMLIBS_OK);
+
+    // The front-ends evaluate handle once
+    LOGGER_HandleTypeDef *handles[] = {&hlog, NULL};
+    uint32_t next                   = 0;
+    LOGGER_DBG(handles[next++], "sample %lu", (unsigned long)next);
+    HOST_CHECK(next == 1);
+
+    printf("%-34s %5s %8s\n", "", "bytes", "cycles");
+    report("LOGGER_log, filtered in the call", SECTION_SIZE(text_log), level_bench_log);
+    report("LOGGER_DBG, runtime threshold", SECTION_SIZE(text_all), level_bench_all);
+    report("LOGGER_DBG, compiled out", SECTION_SIZE(text_info), level_bench_info);
+
+    // Nothing got through the threshold
+    HOST_CHECK(hlog.index == 0);
+
+    return 0;
+}
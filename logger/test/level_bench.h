@@ -0,0 +1,33 @@
+/*
+ * "THE BEER-WARE LICENSE" (Revision 69):
+ * Squadra Corse firmware team wrote this file. As long as you retain this notice
+ * you can do whatever you want with this stuff. If we meet some day, and you
+ * think this stuff is worth it, you can buy us a beer in return.
+ *
+ * Authors
+ * - Federico Carbone [federico.carbone.sc@gmail.com]
+ */
+
+#ifndef LEVEL_BENCH_H
+#define LEVEL_BENCH_H
+
+#include "logger.h"
+
+/* Argument with a cost, the compiler cannot drop its evaluation */
+uint32_t level_bench_value(uint32_t i);
+
+/* Three debug messages and one error, built by level_bench.c with every level compiled in */
+#define LEVEL_BENCH_BODY(handle, i)                                                 \
+    do {                                                                            \
+        LOGGER_DBG((handle), "sample %lu", (unsigned long)level_bench_value(i));    \
+        LOGGER_DBG((handle), "state %lu", (unsigned long)level_bench_value(i + 1)); \
+        LOGGER_DBG((handle), "timer %lu", (unsigned long)level_bench_value(i + 2)); \
+        if (level_bench_value(i) == 0xFFFFFFFFU) {                                  \
+            LOGGER_ERR((handle), "overflow at %lu", (unsigned long)i);              \
+        }                                                                           \
+    } while (0)
+
+/* Same body with LOGGER_COMPILE_LEVEL set to LOGGER_LEVEL_INFO, see level_bench_info.c */
+void level_bench_info(LOGGER_HandleTypeDef *handle, uint32_t i);
+
+#endif  //LEVEL_BENCH_H
@@ -0,0 +1,18 @@
+/*
+ * "THE BEER-WARE LICENSE" (Revision 69):
+ * Squadra Corse firmware team wrote this file. As long as you retain this notice
+ * you can do whatever you want with this stuff. If we meet some day, and you
+ * think this stuff is worth it, you can buy us a beer in return.
+ *
+ * Authors
+ * - Federico Carbone [federico.carbone.sc@gmail.com]
+ */
+
+/* The release build of the benchmark body: debug messages are compiled out */
+#define LOGGER_COMPILE_LEVEL LOGGER_LEVEL_INFO
+
+#include "level_bench.h"
+
+__attribute__((noinline, section("text_info"))) void level_bench_info(LOGGER_HandleTypeDef *handle, uint32_t i) {
+    LEVEL_BENCH_BODY(handle, i);
+}
@@ -0,0 +1,350 @@
+/*
+ * "THE BEER-WARE LICENSE" (Revision 69):
+ * Squadra Corse firmware team wrote this file. As long as you retain this notice
+ * you can do whatever you want with this stuff. If we meet some day, and you
+ * think this stuff is worth it, you can buy us a beer in return.
+ *
+ * Authors
+ * - Federico Carbone [federico.carbone.sc@gmail.com]
+ */
+
+/*
+ * LOGGER on the host: every flushed byte is captured and checked.
+ */
+
+#include "logger.h"
+#include "host.h"
+
+#include <string.h>
+
+static char output[8192];
+static uint32_t output_len;
+
+static STMLIBS_StatusTypeDef capture(char *data, uint32_t size) {
+    HOST_CHECK(output_len + size < sizeof(output));
+    memcpy(output + output_len, data, size);
+    output_len += size;
+    output[output_len] = '\0';
+    return STMLIBS_OK;
+}
+
+static LOGGER_TimestampTypeDef clock_us(void) {
+    return 1234567;
+}
+
+static void modes(void) {
+    static char buffer[256];
+    LOGGER_HandleTypeDef hlog;
+
+    HOST_CHECK(LOGGER_init(&hlog, buffer, sizeof(buffer), capture) == STMLIBS_OK);
+
+    // Modes past LOGGER_RAW are rejected by every entry point
+    const LOGGER_WordTypeDef args[1] = {0};
+    HOST_CHECK(LOGGER_log(&hlog, LOGGER_RAW + 1, "bad") == STMLIBS_ERROR);
+    HOST_CHECK(LOGGER_log_value(&hlog, LOGGER_RAW + 1, "bad ", 1, 0) == STMLIBS_ERROR);
+    HOST_CHECK(LOGGER_log_hex(&hlog, LOGGER_RAW + 1, "bad ", 1) == STMLIBS_ERROR);
+    HOST_CHECK(LOGGER_log_deferred(&hlog, LOGGER_RAW + 1, "bad", 0, args) == STMLIBS_ERROR);
+    HOST_CHECK(hlog.index == 0);
+
+    // The front-ends discard messages to a NULL handle
+    LOGGER_HandleTypeDef *none = NULL;
+    LOGGER_ERR(none, "lost %d", 1);
+    LOGGER_DEFER_ERR(none, "lost %d", 2);
+    LOGGER_LIMIT(none, LOGGER_ERROR, 1000, "lost %d", 3);
+    LOGGER_DEFER_LIMIT(none, LOGGER_ERROR, 1000, "lost %d", 4);
+
+    host_tick = 42;
+    output_len = 0;
+    HOST_CHECK(LOGGER_log(&hlog, LOGGER_RAW, "raw") == STMLIBS_OK);
+    HOST_CHECK(LOGGER_log(&hlog, LOGGER_ERROR, "err %d", 7) == STMLIBS_OK);
+    HOST_CHECK(LOGGER_flush(&hlog) == STMLIBS_OK);
+    HOST_CHECK(strstr(output, "raw\r\n") == output);
+    HOST_CHECK(strstr(output, "[   42] err 7") != NULL);
+}
+
+static void timestamp_source(void) {
+    static char buffer[256];
+    LOGGER_HandleTypeDef hlog;
+
+    HOST_CHECK(LOGGER_init(&hlog, buffer, sizeof(buffer), capture) == STMLIBS_OK);
+    HOST_CHECK(LOGGER_set_timestamp_source(NULL, clock_us, 1) == STMLIBS_ERROR);
+
+    output_len = 0;
+    HOST_CHECK(LOGGER_set_timestamp_source(&hlog, clock_us, 1) == STMLIBS_OK);
+    HOST_CHECK(LOGGER_log(&hlog, LOGGER_INFO, "us") == STMLIBS_OK);
+    HOST_CHECK(LOGGER_flush(&hlog) == STMLIBS_OK);
+    HOST_CHECK(strstr(output, "[   1234567] us") != NULL);
+
+    // Back to HAL_GetTick in milliseconds
+    host_tick  = 9;
+    output_len = 0;
+    HOST_CHECK(LOGGER_set_timestamp_source(&hlog, NULL, 1) == STMLIBS_OK);
+    HOST_CHECK(LOGGER_log(&hlog, LOGGER_INFO, "ms") == STMLIBS_OK);
+    HOST_CHECK(LOGGER_flush(&hlog) == STMLIBS_OK);
+    HOST_CHECK(strstr(output, "[    9] ms") != NULL);
+}
+
+static void deferred_kept(void) {
+    static char buffer[200];
+    static LOGGER_RecordTypeDef storage[4];
+    static CIRCULAR_BUFFER_MPSC_SequenceTypeDef sequences[4];
+    CIRCULAR_BUFFER_MPSC_HandleTypeDef records;
+    LOGGER_HandleTypeDef hlog;
+    char line[118];
+
+    HOST_CHECK(LOGGER_init(&hlog, buffer, sizeof(buffer), capture) == STMLIBS_OK);
+    HOST_CHECK(CIRCULAR_BUFFER_MPSC_init(&records, storage, sequences, 4, sizeof(LOGGER_RecordTypeDef)) == STMLIBS_OK);
+    HOST_CHECK(LOGGER_init_deferred(&hlog, &records) == STMLIBS_OK);
+
+    // 67 bytes are pending: the 117 character line and its header do not fit in the 200 byte buffer
+    memset(line, 'x', sizeof(line) - 1);
+    line[sizeof(line) - 1] = '\0';
+    HOST_CHECK(LOGGER_log(&hlog, LOGGER_RAW, "%067d", 0) == STMLIBS_OK);
+    HOST_CHECK(hlog.index == 67);
+    LOGGER_DEFER(&hlog, LOGGER_INFO, "%s", line);
+
+    output_len = 0;
+    HOST_CHECK(LOGGER_flush(&hlog) == STMLIBS_OK);
+    HOST_CHECK(output_len == 67);
+    HOST_CHECK(!CIRCULAR_BUFFER_MPSC_is_empty(&records));
+
+    // Written by the next flush
+    HOST_CHECK(LOGGER_flush(&hlog) == STMLIBS_OK);
+    HOST_CHECK(strstr(output + 67, line) != NULL);
+    HOST_CHECK(CIRCULAR_BUFFER_MPSC_is_empty(&records));
+
+    // A line that cannot fit even an empty buffer is dropped instead of blocking the queue
+    HOST_CHECK(LOGGER_init(&hlog, buffer, 100, capture) == STMLIBS_OK);
+    HOST_CHECK(LOGGER_init_deferred(&hlog, &records) == STMLIBS_OK);
+    LOGGER_DEFER(&hlog, LOGGER_INFO, "%s", line);
+    LOGGER_DEFER(&hlog, LOGGER_INFO, "short");
+    output_len = 0;
+    HOST_CHECK(LOGGER_flush(&hlog) == STMLIBS_OK);
+    HOST_CHECK(strstr(output, "] short") != NULL);
+    HOST_CHECK(CIRCULAR_BUFFER_MPSC_is_empty(&records));
+}
+
+static LOGGER_TimestampTypeDef now_us;
+
+static LOGGER_TimestampTypeDef clock_now(void) {
+    return now_us;
+}
+
+static void lanes_merged(void) {
+    static char buffer[1024];
+    static LOGGER_RecordTypeDef lane_storage[2][8];
+    static LOGGER_RecordTypeDef storage[8];
+    static CIRCULAR_BUFFER_MPSC_SequenceTypeDef sequences[8];
+    CIRCULAR_BUFFER_SPSC_HandleTypeDef lanes[2];
+    CIRCULAR_BUFFER_MPSC_HandleTypeDef records;
+    LOGGER_HandleTypeDef hlog;
+    const LOGGER_WordTypeDef args[1] = {0};
+
+    HOST_CHECK(LOGGER_init(&hlog, buffer, sizeof(buffer), capture) == STMLIBS_OK);
+    HOST_CHECK(LOGGER_set_timestamp_source(&hlog, clock_now, 1) == STMLIBS_OK);
+    for (uint8_t i = 0; i < 2; ++i) {
+        HOST_CHECK(CIRCULAR_BUFFER_SPSC_init(&lanes[i], lane_storage[i], 8, sizeof(LOGGER_RecordTypeDef)) ==
+                   STMLIBS_OK);
+    }
+    HOST_CHECK(CIRCULAR_BUFFER_MPSC_init(&records, storage, sequences, 8, sizeof(LOGGER_RecordTypeDef)) == STMLIBS_OK);
+    HOST_CHECK(LOGGER_init_lanes(&hlog, lanes, 2) == STMLIBS_OK);
+    HOST_CHECK(LOGGER_init_deferred(&hlog, &records) == STMLIBS_OK);
+    HOST_CHECK(LOGGER_log_lane(&hlog, 2, LOGGER_INFO, "none", 0, args) == STMLIBS_ERROR);
+
+    // Each producer in timestamp order, the producers interleaved; the clock wraps after the third message
+    static const uint8_t producer[] = {0, 1, 2, 2, 0, 1, 1, 2, 0, 0, 2, 1};
+    now_us = UINT32_MAX - 25;
+    for (uint32_t k = 0; k < sizeof(producer); ++k, now_us += 10) {
+        if (producer[k] == 2) {
+            LOGGER_DEFER(&hlog, LOGGER_INFO, "m%lu;", (unsigned long)k);
+        } else {
+            LOGGER_DEFER_LANE(&hlog, producer[k], LOGGER_INFO, "m%lu;", (unsigned long)k);
+        }
+    }
+
+    output_len = 0;
+    HOST_CHECK(LOGGER_flush(&hlog) == STMLIBS_OK);
+
+    // Oldest first whatever queue holds it, each line with its own timestamp
+    const char *at = output;
+    char line[32];
+    for (uint32_t k = 0; k < sizeof(producer); ++k) {
+        snprintf(line, sizeof(line), "[%10" PRIu32 "] m%" PRIu32 ";", (uint32_t)(UINT32_MAX - 25 + 10 * k), k);
+        const char *found = strstr(output, line);
+        HOST_CHECK(found != NULL && found >= at);
+        at = found;
+    }
+    HOST_CHECK(CIRCULAR_BUFFER_MPSC_is_empty(&records));
+    HOST_CHECK(CIRCULAR_BUFFER_SPSC_is_empty(&lanes[0]) && CIRCULAR_BUFFER_SPSC_is_empty(&lanes[1]));
+}
+
+static void truncated(void) {
+    static char buffer[256];
+    LOGGER_HandleTypeDef hlog;
+    char line[301];
+
+    HOST_CHECK(LOGGER_init_async(&hlog, buffer, sizeof(buffer), capture) == STMLIBS_OK);
+    memset(line, 'x', sizeof(line) - 1);
+    line[sizeof(line) - 1] = '\0';
+
+    // Longer than a half: cut at its end, and the flush does not read past it
+    host_tick  = 3;
+    output_len = 0;
+    HOST_CHECK(LOGGER_log(&hlog, LOGGER_INFO, "%s", line) == STMLIBS_ERROR);
+    HOST_CHECK(hlog.index == sizeof(buffer) / 2 - 2);
+    HOST_CHECK(LOGGER_flush(&hlog) == STMLIBS_OK);
+    HOST_CHECK(output_len == sizeof(buffer) / 2 - 2);
+    HOST_CHECK(strstr(output, "[    3] xxx") != NULL && output[output_len - 1] == 'x');
+    HOST_CHECK(LOGGER_flush_complete(&hlog) == STMLIBS_OK);
+
+    // The other half starts empty
+    output_len = 0;
+    HOST_CHECK(LOGGER_log(&hlog, LOGGER_RAW, "next") == STMLIBS_OK);
+    HOST_CHECK(LOGGER_flush(&hlog) == STMLIBS_OK);
+    HOST_CHECK(strcmp(output, "next") == 0);
+    HOST_CHECK(LOGGER_flush_complete(&hlog) == STMLIBS_OK);
+}
+
+/* Decode the COBS frame at src, check its CRC and return the mode, sequence and text */
+static uint32_t decode_frame(const uint8_t *src, uint8_t *raw, uint8_t *mode, uint16_t *sequence, char *text) {
+    uint32_t in = 0, out = 0;
+
+    while (src[in] != 0) {
+        uint8_t code = src[in++];
+        for (uint8_t i = 1; i < code; ++i) {
+            raw[out++] = src[in++];
+        }
+        if (code != 0xFF && src[in] != 0) {
+            raw[out++] = 0;
+        }
+    }
+
+    uint16_t crc = 0xFFFF;
+    for (uint32_t i = 0; i < out - 2; ++i) {
+        crc ^= raw[i] << 8;
+        for (uint8_t bit = 0; bit < 8; ++bit) {
+            crc = crc & 0x8000 ? (crc << 1) ^ 0x1021 : crc << 1;
+        }
+    }
+    HOST_CHECK(raw[out - 2] == (crc & 0xFF) && raw[out - 1] == crc >> 8);
+
+    *mode     = raw[0];
+    *sequence = raw[1] | raw[2] << 8;
+    memcpy(text, raw + 8, out - 10);
+    text[out - 10] = '\0';
+
+    return in + 1;
+}
+
+static void framed(void) {
+    static char buffer[512];
+    LOGGER_HandleTypeDef hlog;
+    uint8_t raw[256];
+    char text[256];
+    uint8_t mode;
+    uint16_t sequence;
+
+    HOST_CHECK(LOGGER_init(&hlog, buffer, sizeof(buffer), capture) == STMLIBS_OK);
+    HOST_CHECK(LOGGER_set_output(&hlog, LOGGER_OUTPUT_FRAMED) == STMLIBS_OK);
+
+    output_len = 0;
+    HOST_CHECK(LOGGER_log(&hlog, LOGGER_WARNING, "zero %d", 0) == STMLIBS_OK);
+    HOST_CHECK(LOGGER_log_hex(&hlog, LOGGER_ERROR, "reg ", 0xCAFE) == STMLIBS_OK);
+    HOST_CHECK(LOGGER_flush(&hlog) == STMLIBS_OK);
+
+    uint32_t offset = decode_frame((uint8_t *)output, raw, &mode, &sequence, text);
+    HOST_CHECK(mode == LOGGER_WARNING && sequence == 0 && strcmp(text, "zero 0") == 0);
+    offset += decode_frame((uint8_t *)output + offset, raw, &mode, &sequence, text);
+    HOST_CHECK(mode == LOGGER_ERROR && sequence == 1 && strcmp(text, "reg 0x0000cafe") == 0);
+    HOST_CHECK(offset == output_len);
+
+    // A dropped line consumes its sequence number, the decoder reports the gap
+    while (LOGGER_log(&hlog, LOGGER_INFO, "%0100d", 0) == STMLIBS_OK) {
+    }
+    uint16_t dropped = hlog.sequence - 1;
+    output_len       = 0;
+    HOST_CHECK(LOGGER_flush(&hlog) == STMLIBS_OK);
+    HOST_CHECK(LOGGER_log(&hlog, LOGGER_INFO, "after") == STMLIBS_OK);
+    HOST_CHECK(LOGGER_flush(&hlog) == STMLIBS_OK);
+
+    offset = 0;
+    while (offset < output_len) {
+        offset += decode_frame((uint8_t *)output + offset, raw, &mode, &sequence, text);
+        HOST_CHECK(sequence != dropped);
+    }
+    HOST_CHECK(sequence == dropped + 1 && strcmp(text, "after") == 0);
+}
+
+/* One call site each */
+static void limited_info(LOGGER_HandleTypeDef *hlog, int n) {
+    LOGGER_LIMIT(hlog, LOGGER_INFO, 1000, "info %d", n);
+}
+
+static void limited_error(LOGGER_HandleTypeDef *hlog, int n) {
+    LOGGER_LIMIT(hlog, LOGGER_ERROR, 1000, "error %d", n);
+}
+
+static void limited_raw(LOGGER_HandleTypeDef *hlog, int n) {
+    LOGGER_LIMIT(hlog, LOGGER_RAW, 1000, "raw %d;", n);
+}
+
+static void rate_limit(void) {
+    static char buffer[256];
+    LOGGER_HandleTypeDef hlog;
+
+    HOST_CHECK(LOGGER_init(&hlog, buffer, sizeof(buffer), capture) == STMLIBS_OK);
+    HOST_CHECK(LOGGER_set_threshold(&hlog, LOGGER_LEVEL_WARNING) == STMLIBS_OK);
+    host_tick  = 5000;
+    output_len = 0;
+
+    // Below the threshold nothing is counted, the site is not even registered
+    for (int i = 0; i < 5; ++i) {
+        limited_info(&hlog, i);
+    }
+    HOST_CHECK(LOGGER_get_sites(&hlog) == NULL);
+
+    for (int i = 0; i < 4; ++i) {
+        limited_error(&hlog, i);
+    }
+    LOGGER_SiteTypeDef *site = LOGGER_get_sites(&hlog);
+    HOST_CHECK(site != NULL && site->suppressed == 3 && site->total_suppressed == 3);
+
+    // The summary does not fit: the count is kept for the next one
+    hlog.index = sizeof(buffer) - 8;
+    host_tick += 1000;
+    limited_error(&hlog, 4);
+    HOST_CHECK(site->suppressed == 3);
+    hlog.index = 0;
+
+    limited_error(&hlog, 5);
+    host_tick += 1000;
+    limited_error(&hlog, 6);
+    HOST_CHECK(site->suppressed == 0 && site->total_suppressed == 4);
+    HOST_CHECK(LOGGER_flush(&hlog) == STMLIBS_OK);
+    HOST_CHECK(strstr(output, "4 messages suppressed") != NULL);
+    HOST_CHECK(strstr(output, "error 6") != NULL);
+
+    // Raw sites print no summary
+    output_len = 0;
+    limited_raw(&hlog, 0);
+    limited_raw(&hlog, 1);
+    host_tick += 1000;
+    limited_raw(&hlog, 2);
+    HOST_CHECK(LOGGER_flush(&hlog) == STMLIBS_OK);
+    HOST_CHECK(strcmp(output, "raw 0;raw 2;") == 0);
+    HOST_CHECK(LOGGER_get_sites(&hlog)->total_suppressed == 1);
+}
+
+int main(void) {
+    modes();
+    timestamp_source();
+    deferred_kept();
+    lanes_merged();
+    truncated();
+    framed();
+    rate_limit();
+
+    printf("logger_test: ok\n");
+
+    return 0;
+}
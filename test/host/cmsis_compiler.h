@@ -0,0 +1,51 @@
+/*
+ * "THE BEER-WARE LICENSE" (Revision 69):
+ * Squadra Corse firmware team wrote this file. As long as you retain this notice
+ * you can do whatever you want with this stuff. If we meet some day, and you
+ * think this stuff is worth it, you can buy us a beer in return.
+ *
+ * Authors
+ * - Federico Carbone [federico.carbone.sc@gmail.com]
+ */
+
+/*
+ * Host replacement of the CMSIS intrinsics: there are no interrupts on the
+ * host, the threads of the tests synchronize with atomics. A thread standing
+ * in for an interrupt calls host_irq_raise, which wakes up __WFI.
+ */
+
+#ifndef CMSIS_COMPILER_H
+#define CMSIS_COMPILER_H
+
+#include <stdint.h>
+
+#ifndef __weak
+#define __weak __attribute__((weak))
+#endif  //__weak
+
+static inline uint32_t __get_PRIMASK(void) {
+    return 0;
+}
+
+static inline void __set_PRIMASK(uint32_t primask) {
+    (void)primask;
+}
+
+static inline void __disable_irq(void) {
+}
+
+static inline void __enable_irq(void) {
+}
+
+static inline void __DMB(void) {
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+}
+
+/* Defined in host.c */
+void host_wfi(void);
+
+static inline void __WFI(void) {
+    host_wfi();
+}
+
+#endif  //CMSIS_COMPILER_H
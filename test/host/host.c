@@ -0,0 +1,59 @@
+/*
+ * "THE BEER-WARE LICENSE" (Revision 69):
+ * Squadra Corse firmware team wrote this file. As long as you retain this notice
+ * you can do whatever you want with this stuff. If we meet some day, and you
+ * think this stuff is worth it, you can buy us a beer in return.
+ *
+ * Authors
+ * - Federico Carbone [federico.carbone.sc@gmail.com]
+ */
+
+#include "host.h"
+#include "main.h"
+
+uint32_t host_tick;
+uint32_t host_tim_clock = 1000000;
+uint8_t host_tim_32bit;
+
+static DWT_Type host_dwt;
+DWT_Type *DWT = &host_dwt;
+
+uint32_t HAL_GetTick(void) {
+    return host_tick;
+}
+
+int HAL_TIM_Base_Start_IT(TIM_HandleTypeDef *htim) {
+    (void)htim;
+    return 0;
+}
+
+void TIM_Base_SetConfig(TIM_TypeDef *TIMx, TIM_Base_InitTypeDef *Structure) {
+    TIMx->ARR = Structure->Period;
+}
+
+uint32_t TIM_GetInternalClkFreq(TIM_HandleTypeDef *htim) {
+    (void)htim;
+    return host_tim_clock;
+}
+
+/* Interrupts raised and the ones __WFI returned for, an interrupt is pending while they differ */
+static pthread_mutex_t host_irq_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t host_irq_cond  = PTHREAD_COND_INITIALIZER;
+static uint32_t host_irq_raised;
+static uint32_t host_irq_served;
+
+void host_irq_raise(void) {
+    pthread_mutex_lock(&host_irq_lock);
+    ++host_irq_raised;
+    pthread_cond_signal(&host_irq_cond);
+    pthread_mutex_unlock(&host_irq_lock);
+}
+
+void host_wfi(void) {
+    pthread_mutex_lock(&host_irq_lock);
+    while (host_irq_served == host_irq_raised) {
+        pthread_cond_wait(&host_irq_cond, &host_irq_lock);
+    }
+    host_irq_served = host_irq_raised;
+    pthread_mutex_unlock(&host_irq_lock);
+}
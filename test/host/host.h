@@ -0,0 +1,56 @@
+/*
+ * "THE BEER-WARE LICENSE" (Revision 69):
+ * Squadra Corse firmware team wrote this file. As long as you retain this notice
+ * you can do whatever you want with this stuff. If we meet some day, and you
+ * think this stuff is worth it, you can buy us a beer in return.
+ *
+ * Authors
+ * - Federico Carbone [federico.carbone.sc@gmail.com]
+ */
+
+/*
+ * Helpers shared by the host tests and benchmarks.
+ */
+
+#ifndef HOST_H
+#define HOST_H
+
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+/** @brief Fail the test with the location when the condition does not hold */
+#define HOST_CHECK(COND)                                                             \
+    do {                                                                             \
+        if (!(COND)) {                                                               \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #COND); \
+            exit(1);                                                                 \
+        }                                                                            \
+    } while (0)
+
+/** @brief Monotonic time in ns */
+static inline uint64_t host_ns(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000U + (uint64_t)now.tv_nsec;
+}
+
+/** @brief Cycle counter of the host, x86 TSC or the monotonic clock in ns elsewhere */
+static inline uint64_t host_cycles(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    return __builtin_ia32_rdtsc();
+#else
+    return host_ns();
+#endif
+}
+
+/**
+ * @brief Called by a thread standing in for an interrupt once its work is done:
+ *        the interrupt is pending until __WFI returns, so one raised before the
+ *        sleep is not lost
+ */
+void host_irq_raise(void);
+
+#endif  //HOST_H
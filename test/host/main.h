@@ -0,0 +1,78 @@
+/*
+ * "THE BEER-WARE LICENSE" (Revision 69):
+ * Squadra Corse firmware team wrote this file. As long as you retain this notice
+ * you can do whatever you want with this stuff. If we meet some day, and you
+ * think this stuff is worth it, you can buy us a beer in return.
+ *
+ * Authors
+ * - Federico Carbone [federico.carbone.sc@gmail.com]
+ */
+
+/*
+ * Host replacement of the CubeMX main.h used by the tests and benchmarks: only
+ * the HAL and CMSIS parts the libraries touch, backed by plain variables.
+ */
+
+#ifndef MAIN_H
+#define MAIN_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct {
+    volatile uint32_t CR1;
+    volatile uint32_t CNT;
+    volatile uint32_t PSC;
+    volatile uint32_t ARR;
+} TIM_TypeDef;
+
+typedef struct {
+    uint32_t CounterMode;
+    uint32_t Period;
+} TIM_Base_InitTypeDef;
+
+typedef struct {
+    TIM_TypeDef *Instance;
+    TIM_Base_InitTypeDef Init;
+} TIM_HandleTypeDef;
+
+typedef struct {
+    volatile uint32_t CTRL;
+    volatile uint32_t CYCCNT;
+} DWT_Type;
+
+/** @brief Advanced by the tests, HAL_GetTick returns it */
+extern uint32_t host_tick;
+/** @brief Clock of every timer in Hz, 1 MHz by default */
+extern uint32_t host_tim_clock;
+/** @brief Non zero to make every timer 32 bit wide */
+extern uint8_t host_tim_32bit;
+extern DWT_Type *DWT;
+
+#define APB2PERIPH_BASE 0x40010000UL
+
+#define TIM_COUNTERMODE_UP 0U
+#define TIM_IT_UPDATE      (1U << 0)
+#define TIM_CR1_ARPE       (1U << 7)
+
+#define SET_BIT(REG, BIT)   ((REG) |= (BIT))
+#define CLEAR_BIT(REG, BIT) ((REG) &= ~(BIT))
+
+#define IS_TIM_32B_COUNTER_INSTANCE(INSTANCE) (host_tim_32bit)
+
+#define __HAL_TIM_SetAutoreload(HANDLE, AUTORELOAD) \
+    do {                                            \
+        (HANDLE)->Instance->ARR = (AUTORELOAD);     \
+        (HANDLE)->Init.Period   = (AUTORELOAD);     \
+    } while (0)
+#define __HAL_TIM_GET_AUTORELOAD(HANDLE)      ((HANDLE)->Instance->ARR)
+#define __HAL_TIM_GetCounter(HANDLE)          ((HANDLE)->Instance->CNT)
+#define __HAL_TIM_GET_COUNTER(HANDLE)         ((HANDLE)->Instance->CNT)
+#define __HAL_TIM_SET_COUNTER(HANDLE, COUNTER) ((HANDLE)->Instance->CNT = (COUNTER))
+#define __HAL_TIM_CLEAR_IT(HANDLE, INTERRUPT) ((void)(HANDLE), (void)(INTERRUPT))
+
+uint32_t HAL_GetTick(void);
+int HAL_TIM_Base_Start_IT(TIM_HandleTypeDef *htim);
+void TIM_Base_SetConfig(TIM_TypeDef *TIMx, TIM_Base_InitTypeDef *Structure);
+
+#endif  //MAIN_H
@@ -0,0 +1,123 @@
+/*
+ * "THE BEER-WARE LICENSE" (Revision 69):
+ * Squadra Corse firmware team wrote this file. As long as you retain this notice
+ * you can do whatever you want with this stuff. If we meet some day, and you
+ * think this stuff is worth it, you can buy us a beer in return.
+ *
+ * Authors
+ * - Federico Carbone [federico.carbone.sc@gmail.com]
+ */
+
+/*
+ * 24 simulated hours of a tickless TIMEBASE on a 1 ms base and a 1 MHz timer,
+ * 16 and 32 bit wide. Every update event advances the time by ARR + 1, as the
+ * hardware does; the ISR runs after a latency, with the counter already past
+ * 0. Some intervals are added while the timer runs. Checked at every update:
+ * the base ticks counted by the timebase match the time, so nothing drifts,
+ * the counter never passes the autoreload the ISR programmed, and an
+ * activation follows its deadline by at most the latency. At the end every
+ * deadline was either activated or counted missed.
+ *
+ * Without latency the activations are exact. With a late ISR, beyond the
+ * nearest deadline every few hundred updates, the period is extended instead
+ * of letting the counter wrap at the timer width.
+ */
+
+#include "host.h"
+#include "timebase.h"
+
+#define DAY_US 86400000000ULL
+
+static const uint32_t ms[] = {10, 100, 250, 1000, 60000, 7, 333};
+#define INTERVALS (sizeof(ms) / sizeof(ms[0]))
+
+static TIM_TypeDef tim;
+static TIM_HandleTypeDef htim = {.Instance = &tim};
+static TIMEBASE_HandleTypeDef htimebase;
+static uint32_t seed = 1;
+
+static uint32_t random_us(uint32_t max) {
+    seed = seed * 1664525U + 1013904223U;
+    return (seed >> 8) % (max + 1);
+}
+
+/* max_late_us is the latency of one update in 256, the others stay within 20 us */
+static void simulate(uint8_t tim_32bit, uint32_t max_late_us) {
+    uint64_t added_at[INTERVALS] = {0};
+    uint64_t last_due[INTERVALS] = {0};
+    uint64_t activations[INTERVALS] = {0};
+    uint64_t updates = 0;
+    uint64_t now     = 0;
+    uint8_t added    = 3;
+
+    host_tim_32bit = tim_32bit;
+    tim.CR1        = TIM_CR1_ARPE;
+    tim.CNT        = 0;
+
+    HOST_CHECK(TIMEBASE_init(&htimebase, &htim, 1000) == STMLIBS_OK);
+    HOST_CHECK(TIMEBASE_set_tickless(&htimebase, 1) == STMLIBS_OK);
+    HOST_CHECK((tim.CR1 & TIM_CR1_ARPE) == 0);
+    for (uint8_t i = 0; i < added; ++i) {
+        HOST_CHECK(TIMEBASE_add_interval(&htimebase, ms[i] * 1000, NULL) == STMLIBS_OK);
+    }
+
+    while (now < DAY_US) {
+        // The others are added one per hour, with the counter somewhere in the running period
+        if (added < INTERVALS && now > added * 3600000000ULL) {
+            tim.CNT         = (tim.ARR + 1) / 3 + 17;
+            added_at[added] = now + tim.CNT;
+            HOST_CHECK(TIMEBASE_add_interval(&htimebase, ms[added] * 1000, NULL) == STMLIBS_OK);
+            HOST_CHECK(tim.CNT <= tim.ARR);
+            ++added;
+        }
+
+        // Update event: the counter restarts from 0 and keeps counting while the ISR is pending
+        now += tim.ARR + 1;
+        tim.CNT = max_late_us != 0 && random_us(255) == 0 ? random_us(max_late_us) : random_us(20);
+
+        TIMEBASE_TimerElapsedCallback(&htimebase, &htim);
+        ++updates;
+
+        HOST_CHECK((uint64_t)htimebase.repetition_counter * 1000 == now);
+        HOST_CHECK(tim.CNT <= tim.ARR);
+
+        for (uint8_t i = 0; i < htimebase.intervals_length; ++i) {
+            if (!(htimebase.intervals_flag & (1U << i))) {
+                continue;
+            }
+
+            uint64_t due = now / (ms[i] * 1000) * (ms[i] * 1000);
+            HOST_CHECK(due > last_due[i]);
+            HOST_CHECK(max_late_us != 0 ? now - due <= max_late_us + 1000 : now == due);
+            last_due[i] = due;
+            ++activations[i];
+        }
+
+        // The routine runs before the next update
+        htimebase.intervals_flag = 0;
+    }
+
+    printf("%s bit, latency up to %5" PRIu32 " us: %10" PRIu64 " updates in 24 h\n",
+           tim_32bit ? "32" : "16",
+           max_late_us,
+           updates);
+
+    for (uint8_t i = 0; i < INTERVALS; ++i) {
+        TIMEBASE_StatsTypeDef stats;
+        HOST_CHECK(TIMEBASE_get_stats(&htimebase, i, &stats) == STMLIBS_OK);
+
+        uint64_t expected = now / (ms[i] * 1000) - added_at[i] / (ms[i] * 1000);
+        HOST_CHECK(activations[i] + stats.missed == expected);
+        HOST_CHECK(max_late_us != 0 || stats.missed == 0);
+    }
+}
+
+int main(void) {
+    simulate(0, 0);
+    simulate(1, 0);
+    simulate(0, 5000);
+
+    printf("drift_test: ok\n");
+
+    return 0;
+}
@@ -0,0 +1,115 @@
+/*
+ * "THE BEER-WARE LICENSE" (Revision 69):
+ * Squadra Corse firmware team wrote this file. As long as you retain this notice
+ * you can do whatever you want with this stuff. If we meet some day, and you
+ * think this stuff is worth it, you can buy us a beer in return.
+ *
+ * Authors
+ * - Federico Carbone [federico.carbone.sc@gmail.com]
+ */
+
+/*
+ * Cycles of one TIMEBASE_TimerElapsedCallback on a 1 ms base with 1, 8 and
+ * 32 intervals: "dense" ones from 1 ms, so every tick activates one and scans
+ * them all, and "sparse" ones from 10 ms. The reference ISR computes the time
+ * in us and a 64 bit modulo per interval on every tick, like the timebase did
+ * before the countdowns: the host divides in hardware, a Cortex-M calls
+ * __aeabi_uldivmod instead. Mean, median and 99th percentile over TICKS
+ * ticks, with the cost of reading the cycle counter subtracted.
+ */
+
+#include "host.h"
+#include "timebase.h"
+
+#define TICKS   2000000U
+#define BUCKETS 4096
+
+static TIM_TypeDef tim;
+static TIM_HandleTypeDef htim = {.Instance = &tim};
+static TIMEBASE_HandleTypeDef htimebase;
+static uint32_t histogram[BUCKETS];
+static uint64_t overhead;
+
+/* ISR before the countdowns: a 64 bit modulo per interval on every tick */
+__attribute__((noinline)) static void modulo_isr(TIMEBASE_HandleTypeDef *handle, TIM_HandleTypeDef *htim) {
+    if (handle->htim == htim) {
+        ++handle->repetition_counter;
+
+        uint64_t time = (uint64_t)handle->repetition_counter * handle->base_interval_us;
+        for (uint8_t i = 0; i < handle->intervals_length; ++i) {
+            if ((time % handle->intervals[i].interval_us) == 0) {
+                handle->intervals_flag |= (1U << i);
+            }
+        }
+    }
+}
+
+static const uint32_t dense[16]  = {1, 2, 5, 10, 20, 50, 100, 200, 500, 1000, 3, 7, 25, 40, 250, 125};
+static const uint32_t sparse[16] = {10, 20, 50, 100, 200, 500, 1000, 30, 70, 250, 40, 120, 150, 300, 2000, 60};
+
+static void run(const uint32_t *ms, uint8_t length, uint8_t modulo) {
+    HOST_CHECK(TIMEBASE_init(&htimebase, &htim, 1000) == STMLIBS_OK);
+    for (uint8_t i = 0; i < length; ++i) {
+        HOST_CHECK(TIMEBASE_add_interval(&htimebase, ms[i % 16] * 1000 * (1 + i / 16), NULL) == STMLIBS_OK);
+    }
+
+    for (uint32_t i = 0; i < BUCKETS; ++i) {
+        histogram[i] = 0;
+    }
+
+    uint64_t total = 0;
+    for (uint32_t tick = 0; tick < TICKS; ++tick) {
+        uint64_t start = host_cycles();
+        if (modulo) {
+            modulo_isr(&htimebase, &htim);
+        } else {
+            TIMEBASE_TimerElapsedCallback(&htimebase, &htim);
+        }
+        uint64_t cycles = host_cycles() - start;
+
+        cycles = cycles > overhead ? cycles - overhead : 0;
+        total += cycles;
+        ++histogram[cycles < BUCKETS ? cycles : BUCKETS - 1];
+    }
+
+    uint32_t count = 0, median = 0, p99 = 0;
+    for (uint32_t cycles = 0; cycles < BUCKETS; ++cycles) {
+        count += histogram[cycles];
+        if (median == 0 && count >= TICKS / 2) {
+            median = cycles;
+        }
+        if (p99 == 0 && count >= TICKS / 100 * 99) {
+            p99 = cycles;
+        }
+    }
+
+    printf("%2u intervals %-6s %-9s %8.1f %8" PRIu32 " %8" PRIu32 "\n",
+           length,
+           ms == dense ? "dense" : "sparse",
+           modulo ? "modulo" : "countdown",
+           (double)total / TICKS,
+           median,
+           p99);
+}
+
+int main(void) {
+    overhead = UINT64_MAX;
+    for (uint32_t i = 0; i < 100000; ++i) {
+        uint64_t start  = host_cycles();
+        uint64_t cycles = host_cycles() - start;
+        if (cycles < overhead) {
+            overhead = cycles;
+        }
+    }
+
+    printf("%-29s %8s %8s %8s\n", "", "mean", "median", "p99");
+    static const uint8_t lengths[] = {1, 8, 32};
+    for (uint32_t i = 0; i < sizeof(lengths) / sizeof(lengths[0]); ++i) {
+        run(dense, lengths[i], 1);
+        run(dense, lengths[i], 0);
+        run(sparse, lengths[i], 1);
+        run(sparse, lengths[i], 0);
+    }
+
+    return 0;
+}
@@ -0,0 +1,96 @@
+/*
+ * "THE BEER-WARE LICENSE" (Revision 69):
+ * Squadra Corse firmware team wrote this file. As long as you retain this notice
+ * you can do whatever you want with this stuff. If we meet some day, and you
+ * think this stuff is worth it, you can buy us a beer in return.
+ *
+ * Authors
+ * - Federico Carbone [federico.carbone.sc@gmail.com]
+ */
+
+/*
+ * Activations seen by TIMEBASE_routine, built with TIMEBASE_STATS: one
+ * activation runs the callbacks once, two before the routine are coalesced
+ * and counted missed, and one arriving while its own callbacks run is kept
+ * for the next routine call instead. Callback errors and the latency
+ * measured with DWT->CYCCNT are accounted.
+ */
+
+#include "host.h"
+#include "timebase.h"
+
+static TIM_TypeDef tim;
+static TIM_HandleTypeDef htim = {.Instance = &tim};
+static TIMEBASE_HandleTypeDef htimebase;
+static uint32_t calls;
+static uint32_t ticks_in_callback;
+
+static void tick(uint32_t ticks) {
+    for (uint32_t i = 0; i < ticks; ++i) {
+        DWT->CYCCNT += 100;
+        TIMEBASE_TimerElapsedCallback(&htimebase, &htim);
+    }
+}
+
+static STMLIBS_StatusTypeDef callback(void) {
+    ++calls;
+    // The ISR preempts the callback
+    tick(ticks_in_callback);
+    return STMLIBS_OK;
+}
+
+static STMLIBS_StatusTypeDef failing(void) {
+    return STMLIBS_ERROR;
+}
+
+int main(void) {
+    TIMEBASE_StatsTypeDef stats;
+    uint8_t index;
+
+    HOST_CHECK(TIMEBASE_init(&htimebase, &htim, 1000) == STMLIBS_OK);
+    HOST_CHECK(TIMEBASE_add_interval(&htimebase, 2000, &index) == STMLIBS_OK);
+    HOST_CHECK(TIMEBASE_register_callback(&htimebase, index, callback) == STMLIBS_OK);
+    HOST_CHECK(TIMEBASE_register_callback(&htimebase, index, failing) == STMLIBS_OK);
+
+    // Not due yet
+    tick(1);
+    HOST_CHECK(TIMEBASE_routine(&htimebase) == STMLIBS_OK);
+    HOST_CHECK(calls == 0);
+
+    tick(1);
+    HOST_CHECK(TIMEBASE_routine(&htimebase) == STMLIBS_OK);
+    HOST_CHECK(calls == 1);
+
+    // Two activations before the routine: one run, one missed
+    tick(4);
+    HOST_CHECK(TIMEBASE_routine(&htimebase) == STMLIBS_OK);
+    HOST_CHECK(calls == 2);
+    HOST_CHECK(TIMEBASE_get_stats(&htimebase, index, &stats) == STMLIBS_OK);
+    HOST_CHECK(stats.runs == 2 && stats.missed == 1 && stats.errors == 2);
+
+    // Activated again while its callbacks run: neither lost nor missed, the next call runs it
+    tick(2);
+    ticks_in_callback = 2;
+    HOST_CHECK(TIMEBASE_routine(&htimebase) == STMLIBS_OK);
+    HOST_CHECK(calls == 3);
+    ticks_in_callback = 0;
+    HOST_CHECK(TIMEBASE_routine(&htimebase) == STMLIBS_OK);
+    HOST_CHECK(calls == 4);
+    HOST_CHECK(TIMEBASE_routine(&htimebase) == STMLIBS_OK);
+    HOST_CHECK(calls == 4);
+
+    HOST_CHECK(TIMEBASE_get_stats(&htimebase, index, &stats) == STMLIBS_OK);
+    HOST_CHECK(stats.runs == 4 && stats.missed == 1 && stats.errors == 4);
+
+    // Every tick is 100 cycles: the coalesced run started two ticks after its first activation, the others at once
+    HOST_CHECK(stats.latency_min == 0 && stats.latency_max == 200 && stats.latency_histogram[0] == 4);
+    HOST_CHECK(stats.callbacks[0].max == 200 && stats.callbacks[1].max == 0);
+
+    HOST_CHECK(TIMEBASE_reset_stats(&htimebase, index) == STMLIBS_OK);
+    HOST_CHECK(TIMEBASE_get_stats(&htimebase, index, &stats) == STMLIBS_OK);
+    HOST_CHECK(stats.runs == 0 && stats.missed == 0 && stats.latency_min == UINT32_MAX);
+
+    printf("routine_test: ok\n");
+
+    return 0;
+}
@@ -10,8 +10,11 @@
 
 #include "timebase.h"
 
+#include "critical_section.h"
 #include "timer_utils.h"
 
+#include <string.h>
+
 STMLIBS_StatusTypeDef TIMEBASE_init(TIMEBASE_HandleTypeDef *handle,
                                     TIM_HandleTypeDef *htim,
                                     uint32_t base_interval_us) {
@@ -29,13 +32,135 @@ STMLIBS_StatusTypeDef TIMEBASE_init(TIMEBASE_HandleTypeDef *handle,
 
     __HAL_TIM_SetAutoreload(handle->htim, ticks);
 
+    handle->base_ticks         = ticks + 1;
     handle->repetition_counter = 0;
+    handle->span               = 0;
+    handle->countdown          = 0;
+    handle->reload             = 1;
+    handle->max_reload         = 1;
+    handle->tickless           = 0;
     handle->intervals_length   = 0;
     handle->intervals_flag     = 0;
 
     return STMLIBS_OK;
 }
 
+/**
+ * @brief     Clear the statistics of an interval, the ISR may be running
+ */
+static void _TIMEBASE_reset_stats(TIMEBASE_StatsTypeDef *stats) {
+    CS_ENTER();
+
+    memset(stats, 0, sizeof(*stats));
+#ifdef TIMEBASE_STATS
+    stats->latency_min = UINT32_MAX;
+    for (uint8_t i = 0; i < TIMEBASE_MAX_CALLBACKS; ++i) {
+        stats->callbacks[i].min = UINT32_MAX;
+    }
+#endif  //TIMEBASE_STATS
+
+    CS_EXIT();
+}
+
+#ifdef TIMEBASE_STATS
+/**
+ * @brief     Account the latency of an activation, in cycles
+ */
+static inline void _TIMEBASE_stats_latency(TIMEBASE_StatsTypeDef *stats, uint32_t cycles) {
+    if (cycles < stats->latency_min) {
+        stats->latency_min = cycles;
+    }
+    if (cycles > stats->latency_max) {
+        stats->latency_max = cycles;
+    }
+
+    // Bucket of the highest bit above the shift, so every bucket doubles the range of the previous one
+    uint32_t scaled = cycles >> TIMEBASE_STATS_HISTOGRAM_SHIFT;
+    uint8_t bucket  = scaled == 0 ? 0 : 32 - __builtin_clz(scaled);
+    if (bucket >= TIMEBASE_STATS_HISTOGRAM_LENGTH) {
+        bucket = TIMEBASE_STATS_HISTOGRAM_LENGTH - 1;
+    }
+    ++stats->latency_histogram[bucket];
+}
+
+/**
+ * @brief     Account the cycles since start to the profile of a callback
+ */
+static inline void _TIMEBASE_stats_profile(TIMEBASE_ProfileTypeDef *profile, uint32_t start) {
+    uint32_t cycles = TIMEBASE_GET_CYCLES() - start;
+
+    if (cycles < profile->min) {
+        profile->min = cycles;
+    }
+    if (cycles > profile->max) {
+        profile->max = cycles;
+    }
+    profile->total += cycles;
+}
+
+#define _TIMEBASE_stats_begin() TIMEBASE_GET_CYCLES()
+#else
+#define _TIMEBASE_stats_begin()                 0U
+#define _TIMEBASE_stats_latency(stats, cycles)  ((void)0)
+#define _TIMEBASE_stats_profile(profile, start) ((void)(start))
+#endif  //TIMEBASE_STATS
+
+/**
+ * @brief     Program the next timer period, up to the countdown. An ISR served
+ *                later than the countdown finds the counter already past that
+ *                autoreload, where it would run up to the timer width and wrap:
+ *                the period is extended to the first base interval ahead of the
+ *                counter instead, and the ISR accounts the activations as late
+ *
+ * @param     handle Reference to the handle
+ */
+static void _TIMEBASE_reload(TIMEBASE_HandleTypeDef *handle) {
+    uint32_t reload = handle->countdown < handle->max_reload ? handle->countdown : handle->max_reload;
+
+    for (;;) {
+        __HAL_TIM_SetAutoreload(handle->htim, reload * handle->base_ticks - 1);
+
+        // Read after the write, the counter keeps running meanwhile
+        uint32_t counter = __HAL_TIM_GET_COUNTER(handle->htim);
+        if (counter < reload * handle->base_ticks || reload == handle->max_reload) {
+            break;
+        }
+
+        reload = counter / handle->base_ticks + 1;
+        if (reload > handle->max_reload) {
+            reload = handle->max_reload;
+        }
+    }
+
+    handle->reload = reload;
+}
+
+STMLIBS_StatusTypeDef TIMEBASE_set_tickless(TIMEBASE_HandleTypeDef *handle, uint8_t tickless) {
+    if (handle == NULL) {
+        return STMLIBS_ERROR;
+    }
+
+    // The running period cannot change length, the mode is chosen before the timer starts
+    if (handle->intervals_length != 0) {
+        return STMLIBS_ERROR;
+    }
+
+    handle->tickless   = tickless;
+    handle->reload     = 1;
+    handle->max_reload = 1;
+    __HAL_TIM_SetAutoreload(handle->htim, handle->base_ticks - 1);
+
+    if (tickless) {
+        handle->max_reload = ((uint64_t)TIM_GET_MAX_AUTORELOAD(handle->htim) + 1) / handle->base_ticks;
+
+        // A new autoreload must apply to the running period, not to the next one
+        CLEAR_BIT(handle->htim->Instance->CR1, TIM_CR1_ARPE);
+        __HAL_TIM_SET_COUNTER(handle->htim, 0);
+    }
+
+    return STMLIBS_OK;
+}
+
 STMLIBS_StatusTypeDef TIMEBASE_add_interval(TIMEBASE_HandleTypeDef *handle,
                                             uint32_t interval_us,
                                             uint8_t *interval_index) {
@@ -43,7 +168,7 @@ STMLIBS_StatusTypeDef TIMEBASE_add_interval(TIMEBASE_HandleTypeDef *handle,
         return STMLIBS_ERROR;
     }
 
-    if (interval_us % handle->base_interval_us != 0) {
+    if (interval_us == 0 || interval_us % handle->base_interval_us != 0) {
         return STMLIBS_ERROR;
     }
 
@@ -51,19 +176,46 @@ STMLIBS_StatusTypeDef TIMEBASE_add_interval(TIMEBASE_HandleTypeDef *handle,
         return STMLIBS_ERROR;
     }
 
-    if (handle->intervals_length == 0) {
-        __HAL_TIM_CLEAR_IT(handle->htim, TIM_IT_UPDATE);
-        HAL_TIM_Base_Start_IT(handle->htim);
-    }
+    TIMEBASE_IntervalTypeDef *interval = &handle->intervals[handle->intervals_length];
 
-    handle->intervals[handle->intervals_length].interval_us      = interval_us;
-    handle->intervals[handle->intervals_length].callbacks_length = 0;
+    interval->interval_us      = interval_us;
+    interval->ticks            = interval_us / handle->base_interval_us;
+    interval->callbacks_length = 0;
+    _TIMEBASE_reset_stats(&interval->stats);
 
     if (interval_index != NULL)
         *interval_index = handle->intervals_length;
 
+    CS_ENTER();
+
+    // Base ticks counted by the timer since the last ISR, only a tickless period is longer than one
+    uint32_t partial = handle->tickless ? __HAL_TIM_GET_COUNTER(handle->htim) / handle->base_ticks : 0;
+
+    // Activations stay aligned to multiples of the interval since TIMEBASE_init, as when they were computed by the ISR
+    uint32_t elapsed = handle->span - handle->countdown;
+    uint32_t next    = partial + interval->ticks - (handle->repetition_counter + partial) % interval->ticks;
+
+    interval->remaining = elapsed + next;
+    if (handle->intervals_length == 0 || next < handle->countdown) {
+        handle->countdown = next;
+        handle->span      = elapsed + next;
+
+        // Still ahead of the counter: next is at least one base interval past it
+        if (handle->tickless && (handle->intervals_length == 0 || next < handle->reload)) {
+            _TIMEBASE_reload(handle);
+        }
+    }
+
     ++handle->intervals_length;
 
+    CS_EXIT();
+
+    // Started once the countdown is set, the ISR relies on it
+    if (handle->intervals_length == 1) {
+        __HAL_TIM_CLEAR_IT(handle->htim, TIM_IT_UPDATE);
+        HAL_TIM_Base_Start_IT(handle->htim);
+    }
+
     return STMLIBS_OK;
 }
 
@@ -97,30 +249,123 @@ STMLIBS_StatusTypeDef TIMEBASE_routine(TIMEBASE_HandleTypeDef *handle) {
     }
 
     for (uint8_t i = 0; i < handle->intervals_length; ++i) {
-        if (!(handle->intervals_flag & (1 << i)))
+        if (!(handle->intervals_flag & (1U << i)))
             continue;
 
-        for (uint8_t j = 0; j < handle->intervals[i].callbacks_length; ++j) {
-            if (handle->intervals[i].callbacks[j]() != STMLIBS_OK) {
-                // LOG SOMEHOW
+        TIMEBASE_IntervalTypeDef *interval = &handle->intervals[i];
+
+        // Cleared before the callbacks: an activation while they run sets it again and is run by the next call
+        CS_ENTER();
+        handle->intervals_flag &= ~(1U << i);
+#ifdef TIMEBASE_STATS
+        uint32_t activated_at = interval->activated_at;
+#endif  //TIMEBASE_STATS
+        CS_EXIT();
+
+        _TIMEBASE_stats_latency(&interval->stats, _TIMEBASE_stats_begin() - activated_at);
+
+        for (uint8_t j = 0; j < interval->callbacks_length; ++j) {
+            uint32_t start = _TIMEBASE_stats_begin();
+
+            if (interval->callbacks[j]() != STMLIBS_OK) {
+                ++interval->stats.errors;
             }
+
+            _TIMEBASE_stats_profile(&interval->stats.callbacks[j], start);
         }
 
-        handle->intervals_flag &= ~(1 << i);
+        ++interval->stats.runs;
+    }
+
+    return STMLIBS_OK;
+}
+
+STMLIBS_StatusTypeDef TIMEBASE_get_stats(TIMEBASE_HandleTypeDef *handle,
+                                         uint8_t interval_index,
+                                         TIMEBASE_StatsTypeDef *stats) {
+    if (handle == NULL || stats == NULL) {
+        return STMLIBS_ERROR;
+    }
+
+    if (interval_index >= handle->intervals_length) {
+        return STMLIBS_ERROR;
+    }
+
+    // missed is written by the ISR
+    CS_ENTER();
+    *stats = handle->intervals[interval_index].stats;
+    CS_EXIT();
+
+    return STMLIBS_OK;
+}
+
+STMLIBS_StatusTypeDef TIMEBASE_reset_stats(TIMEBASE_HandleTypeDef *handle, uint8_t interval_index) {
+    if (handle == NULL) {
+        return STMLIBS_ERROR;
+    }
+
+    if (interval_index >= handle->intervals_length) {
+        return STMLIBS_ERROR;
     }
 
+    _TIMEBASE_reset_stats(&handle->intervals[interval_index].stats);
+
     return STMLIBS_OK;
 }
 
 void TIMEBASE_TimerElapsedCallback(TIMEBASE_HandleTypeDef *handle, TIM_HandleTypeDef *htim) {
     if (handle->htim == htim) {
-        ++handle->repetition_counter;
-        
-        uint64_t time = (uint64_t)handle->repetition_counter * handle->base_interval_us;
+        handle->repetition_counter += handle->reload;
+
+        // Most ticks activate nothing: only the countdown of the nearest activation is decremented
+        if (handle->reload < handle->countdown) {
+            handle->countdown -= handle->reload;
+            if (handle->tickless) {
+                _TIMEBASE_reload(handle);
+            }
+            return;
+        }
+
+        // Base ticks since the last scan, past the span only when _TIMEBASE_reload extended a late period
+        uint32_t elapsed = handle->span + (handle->reload - handle->countdown);
+
+        uint32_t span = UINT32_MAX;
         for (uint8_t i = 0; i < handle->intervals_length; ++i) {
-            if ((time % handle->intervals[i].interval_us) == 0) {
-                handle->intervals_flag |= (1 << i);
+            TIMEBASE_IntervalTypeDef *interval = &handle->intervals[i];
+
+            if (interval->remaining > elapsed) {
+                interval->remaining -= elapsed;
+            } else {
+                uint32_t late = elapsed - interval->remaining;
+
+                // Still set: the routine has not run the previous activation, the two are coalesced
+                if (handle->intervals_flag & (1U << i)) {
+                    ++interval->stats.missed;
+                } else {
+                    handle->intervals_flag |= (1U << i);
+#ifdef TIMEBASE_STATS
+                    interval->activated_at = TIMEBASE_GET_CYCLES();
+#endif  //TIMEBASE_STATS
+                }
+
+                // Activations skipped by a late period are missed, the next one stays aligned
+                if (late >= interval->ticks) {
+                    interval->stats.missed += late / interval->ticks;
+                    late %= interval->ticks;
+                }
+                interval->remaining = interval->ticks - late;
+            }
+
+            if (interval->remaining < span) {
+                span = interval->remaining;
             }
         }
+
+        handle->span      = span;
+        handle->countdown = span;
+
+        if (handle->tickless) {
+            _TIMEBASE_reload(handle);
+        }
     }
 }
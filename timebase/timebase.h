@@ -22,12 +22,72 @@
 #define TIMEBASE_MAX_CALLBACKS 16
 #endif  //TIMEBASE_MAX_CALLBACKS
 
+/*
+ * Build with -DTIMEBASE_STATS to also measure, in cycles, the latency from the
+ * activation in the ISR to the start of the callbacks and the execution time of
+ * every callback. Runs, missed activations and callback errors are always
+ * counted.
+ */
+#ifdef TIMEBASE_STATS
+/** @brief Cycle counter used by the statistics, DWT->CYCCNT must be enabled by the application */
+#ifndef TIMEBASE_GET_CYCLES
+#define TIMEBASE_GET_CYCLES() (DWT->CYCCNT)
+#endif  //TIMEBASE_GET_CYCLES
+
+#ifndef TIMEBASE_STATS_HISTOGRAM_LENGTH
+#define TIMEBASE_STATS_HISTOGRAM_LENGTH 8
+#endif  //TIMEBASE_STATS_HISTOGRAM_LENGTH
+
+/** @brief The first bucket of the latency histogram counts latencies below 2^TIMEBASE_STATS_HISTOGRAM_SHIFT cycles */
+#ifndef TIMEBASE_STATS_HISTOGRAM_SHIFT
+#define TIMEBASE_STATS_HISTOGRAM_SHIFT 10
+#endif  //TIMEBASE_STATS_HISTOGRAM_SHIFT
+#endif  //TIMEBASE_STATS
+
 typedef STMLIBS_StatusTypeDef (*TIMEBASE_CallbackTypeDef)(void);
 
+#ifdef TIMEBASE_STATS
+/** @brief Cycles spent in a callback per call, the mean is total / runs of its interval */
+struct TIMEBASE_ProfileStruct {
+    uint32_t min;
+    uint32_t max;
+    uint64_t total;
+};
+typedef struct TIMEBASE_ProfileStruct TIMEBASE_ProfileTypeDef;
+#endif  //TIMEBASE_STATS
+
+struct TIMEBASE_StatsStruct {
+    /** @brief Activations whose callbacks were run by TIMEBASE_routine */
+    uint32_t runs;
+    /** @brief Activations lost because the previous one had not been run yet */
+    uint32_t missed;
+    /** @brief Callbacks not returning STMLIBS_OK */
+    uint32_t errors;
+#ifdef TIMEBASE_STATS
+    /** @brief Cycles from the activation in the ISR to the start of the first callback */
+    uint32_t latency_min;
+    uint32_t latency_max;
+    /** @brief Bucket i > 0 counts latencies below 2^(TIMEBASE_STATS_HISTOGRAM_SHIFT + i) cycles not in the previous ones, the last one all the rest */
+    uint32_t latency_histogram[TIMEBASE_STATS_HISTOGRAM_LENGTH];
+    TIMEBASE_ProfileTypeDef callbacks[TIMEBASE_MAX_CALLBACKS];
+#endif  //TIMEBASE_STATS
+};
+typedef struct TIMEBASE_StatsStruct TIMEBASE_StatsTypeDef;
+
 struct TIMEBASE_IntervalStruct {
     uint32_t interval_us;
+    /** @brief Period in base ticks, interval_us / base_interval_us */
+    uint32_t ticks;
+    /** @brief Base ticks from the last scan of the ISR to the next activation */
+    uint32_t remaining;
     TIMEBASE_CallbackTypeDef callbacks[TIMEBASE_MAX_CALLBACKS];
     uint8_t callbacks_length;
+
+    TIMEBASE_StatsTypeDef stats;
+#ifdef TIMEBASE_STATS
+    /** @brief Cycle counter at the pending activation */
+    uint32_t activated_at;
+#endif  //TIMEBASE_STATS
 };
 typedef struct TIMEBASE_IntervalStruct TIMEBASE_IntervalTypeDef;
 
@@ -37,6 +97,19 @@ struct TIMEBASE_HandleStruct {
     uint32_t repetition_counter;
 
     uint32_t base_interval_us;
+    /** @brief Timer ticks of a base interval, autoreload + 1 when not tickless */
+    uint32_t base_ticks;
+
+    /** @brief Base ticks between the last scan of the intervals and the next one, the nearest activation */
+    uint32_t span;
+    /** @brief Base ticks left before the next scan, the ISR only decrements it meanwhile */
+    uint32_t countdown;
+
+    /** @brief Base ticks of the running timer period, always 1 unless tickless */
+    uint32_t reload;
+    /** @brief Longest timer period in base ticks allowed by the autoreload width */
+    uint32_t max_reload;
+    uint8_t tickless;
 
     TIMEBASE_IntervalTypeDef intervals[TIMEBASE_MAX_INTERVALS];
     uint32_t intervals_flag;
@@ -52,6 +125,21 @@ typedef struct TIMEBASE_HandleStruct TIMEBASE_HandleTypeDef;
  * @return    STMLIBS_OK on success, STMLIBS_ERROR on failure
  */
 STMLIBS_StatusTypeDef TIMEBASE_init(TIMEBASE_HandleTypeDef *handle, TIM_HandleTypeDef *htim, uint32_t base_interval_us);
+/**
+ * @brief     Enable the tickless mode: instead of an interrupt every base interval,
+ *                the autoreload is programmed to the next activation, or to the
+ *                longest multiple of the base interval the timer can count. The
+ *                periods are whole base intervals counted by the timer, so the
+ *                activations do not drift. Autoreload preload (ARPE) is disabled,
+ *                the ISR programs the period that is already running: an ISR
+ *                served after the next deadline extends the period to the next
+ *                base interval, delaying that activation but not the later ones
+ *
+ * @param     handle Reference to the handle
+ * @param     tickless 1 to enable, 0 to disable
+ * @return    STMLIBS_OK on success, STMLIBS_ERROR if an interval was already added
+ */
+STMLIBS_StatusTypeDef TIMEBASE_set_tickless(TIMEBASE_HandleTypeDef *handle, uint8_t tickless);
 /**
  * @brief     Adds an interval to the specified TIMEBASE_HandleTypeDef structure
  * 
@@ -81,6 +169,26 @@ STMLIBS_StatusTypeDef TIMEBASE_register_callback(TIMEBASE_HandleTypeDef *handle,
  * @return    STMLIBS_OK on success, STMLIBS_ERROR on failure
  */
 STMLIBS_StatusTypeDef TIMEBASE_routine(TIMEBASE_HandleTypeDef *handle);
+/**
+ * @brief     Copy the statistics of an interval, collected since it was added or
+ *                since the last TIMEBASE_reset_stats
+ *
+ * @param     handle Reference to the handle
+ * @param     interval_index Index of the interval returned by @TIMEBASE_add_interval
+ * @param     stats Reference to the copy
+ * @return    STMLIBS_OK on success, STMLIBS_ERROR on failure
+ */
+STMLIBS_StatusTypeDef TIMEBASE_get_stats(TIMEBASE_HandleTypeDef *handle,
+                                         uint8_t interval_index,
+                                         TIMEBASE_StatsTypeDef *stats);
+/**
+ * @brief     Clear the statistics of an interval
+ *
+ * @param     handle Reference to the handle
+ * @param     interval_index Index of the interval returned by @TIMEBASE_add_interval
+ * @return    STMLIBS_OK on success, STMLIBS_ERROR on failure
+ */
+STMLIBS_StatusTypeDef TIMEBASE_reset_stats(TIMEBASE_HandleTypeDef *handle, uint8_t interval_index);
 /**
  * @brief     Function to be called in the HAL_TIM_PeriodElapsedCallback function
  * 